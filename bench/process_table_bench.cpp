@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "process_filter.h"
+#include "process_table.h"
+
+/*
+Times ProcessTable sorting and filtering at 100k synthetic rows, next to
+the same sort over a vector of whole process records for comparison.
+Usage: bench [rows] [repetitions]
+*/
+
+namespace {
+// The layout ProcessTable replaced: one record per process
+struct Record {
+  int pid;
+  float cpu;
+  float wait;
+  long ram;
+  long up_time;
+  char state;
+  long start_time;
+  int uid;
+  std::string user;
+  std::string command;
+};
+
+// Median wall time of repetitions runs of work, in milliseconds
+double Time(int repetitions, const std::function<void()>& setup,
+            const std::function<void()>& work) {
+  std::vector<double> times;
+  for (int i = 0; i < repetitions; ++i) {
+    setup();
+    auto start = std::chrono::steady_clock::now();
+    work();
+    auto end = std::chrono::steady_clock::now();
+    times.push_back(
+        std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+void Report(const std::string& name, double milliseconds) {
+  std::cout << name << ": " << milliseconds << " ms\n";
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t const rows = argc > 1 ? std::stoul(argv[1]) : 100000;
+  int const repetitions = argc > 2 ? std::stoi(argv[2]) : 21;
+  const char states[] = {'R', 'S', 'S', 'S', 'D', 'I', 'Z'};
+
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> fraction(0, 1);
+  ProcessTable table;
+  std::vector<Record> records;
+  table.Reserve(rows);
+  records.reserve(rows);
+  for (std::size_t i = 0; i < rows; ++i) {
+    Record record{(int)i + 1,
+                  fraction(random) * fraction(random),
+                  fraction(random) * 0.1f,
+                  (long)(random() % 1000000),
+                  (long)(random() % 100000),
+                  states[random() % sizeof(states)],
+                  (long)(random() % 10000000),
+                  (int)(random() % 5) * 1000,
+                  "user" + std::to_string(random() % 5),
+                  "/usr/bin/synthetic --worker " + std::to_string(i)};
+    table.Append(record.pid, record.cpu, record.ram, record.up_time,
+                 record.state, record.start_time, "");
+    table.SetRunQueueWait(i, record.wait);
+    table.SetDetails(i, record.uid, record.user, record.command);
+    records.push_back(std::move(record));
+  }
+  std::cout << rows << " rows, median of " << repetitions << " runs\n";
+
+  auto reset = [&]() { table.Filter([](std::size_t) { return true; }); };
+  Report("ProcessTable::Sort(kCpu)", Time(repetitions, reset, [&]() {
+           table.Sort(ProcessTable::Column::kCpu);
+         }));
+  Report("ProcessTable::Sort(kRam)", Time(repetitions, reset, [&]() {
+           table.Sort(ProcessTable::Column::kRam);
+         }));
+
+  std::vector<Record> shuffled;
+  Report("vector<Record> sort by cpu",
+         Time(
+             repetitions, [&]() { shuffled = records; },
+             [&]() {
+               std::sort(shuffled.begin(), shuffled.end(),
+                         [](const Record& a, const Record& b) {
+                           if (a.cpu != b.cpu) return b.cpu < a.cpu;
+                           return a.pid < b.pid;
+                         });
+             }));
+
+  ProcessFilter const cpu_filter("cpu:50");
+  ProcessFilter const state_filter("state:RD");
+  ProcessFilter const command_filter("worker 7");
+  ProcessFilter const refined_filter("worker 77");
+  auto filter = [&](const ProcessFilter& matcher) {
+    table.Filter([&](std::size_t row) { return matcher.Matches(table, row); });
+  };
+  Report("Filter cpu:50", Time(repetitions, reset,
+                               [&]() { filter(cpu_filter); }));
+  Report("Filter state:RD", Time(repetitions, reset,
+                                 [&]() { filter(state_filter); }));
+  Report("Filter worker 7", Time(repetitions, reset,
+                                 [&]() { filter(command_filter); }));
+  Report("Refine worker 7 -> worker 77",
+         Time(
+             repetitions, [&]() { filter(command_filter); },
+             [&]() {
+               table.Refine([&](std::size_t row) {
+                 return refined_filter.Matches(table, row);
+               });
+             }));
+}
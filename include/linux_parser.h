@@ -1,19 +1,25 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <cstddef>
 #include <fstream>
 #include <regex>
 #include <string>
 
 namespace LinuxParser {
 // Paths
-const std::string kProcDirectory{"/proc/"};
+// The proc root defaults to /proc/ and can be pointed at a synthetic copy
+const std::string& ProcDirectory();
+void SetProcDirectory(std::string directory);
 const std::string kCmdlineFilename{"/cmdline"};
 const std::string kCpuinfoFilename{"/cpuinfo"};
 const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
+const std::string kLoadavgFilename{"/loadavg"};
+const std::string kSchedstatFilename{"/schedstat"};
+const std::string kPressureDirectory{"pressure/"};
 const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
@@ -27,6 +33,16 @@ int RunningProcesses();
 std::string OperatingSystem();
 std::string Kernel();
 
+// Load and pressure stall information
+struct LoadAvg {
+  float one{0};
+  float five{0};
+  float fifteen{0};
+};
+bool LoadAverage(LoadAvg& load);
+// "some" total stall time of /proc/pressure/<resource>, in microseconds
+bool PressureTotal(const std::string& resource, long& total);
+
 // CPU
 enum CPUStates {
   kUser_ = 0,
@@ -40,18 +56,50 @@ enum CPUStates {
   kGuest_,
   kGuestNice_
 };
-std::vector<std::string> CpuUtilization();
 long Jiffies();
 long ActiveJiffies();
-long ActiveJiffies(int pid);
 long IdleJiffies();
+struct CpuTimes {
+  long user{0};
+  long nice{0};
+  long system{0};
+  long idle{0};
+  long iowait{0};
+  long irq{0};
+  long softirq{0};
+  long steal{0};
+  long guest{0};
+  long guest_nice{0};
+};
+bool SystemCpuTimes(CpuTimes& times);
 
 // Processes
 std::string Command(int pid);
-std::string Ram(int pid);
 std::string Uid(int pid);
-std::string User(int pid);
-long int UpTime(int pid);
+std::string UserName(int uid);
+
+// Fields gathered from a single read of /proc/PID/stat
+// (2) comm is 15 characters for tasks, longer for some kernel threads
+const std::size_t kCommLength{64};
+struct ProcStat {
+  char comm[kCommLength]{};  // truncated to kCommLength - 1
+  char state{'?'};
+  long active_jiffies{0};  // (14)-(17) utime + stime + cutime + cstime
+  long start_time{0};      // (22) starttime, in clock ticks after boot
+  long rss{0};             // (24) rss, in pages
+};
+bool ProcessStat(int pid, ProcStat& stat);
+// Time spent waiting on a run queue, from /proc/PID/schedstat, in ns
+bool RunQueueWait(int pid, long& wait);
+
+// Parsers behind the readers above. Each takes the '\0' terminated contents
+// of one file, never throws or allocates, and returns false when the
+// contents are truncated or malformed.
+bool ParseCpuTimes(const char* buffer, CpuTimes& times);
+bool ParseProcStat(const char* buffer, ProcStat& stat);
+bool ParseMemInfo(const char* buffer, long& total, long& free);
+bool ParseStatusField(const char* buffer, const char* key, long& value);
+std::size_t ParseCmdline(char* buffer, std::size_t length);
 };  // namespace LinuxParser
 
 #endif
\ No newline at end of file
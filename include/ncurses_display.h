@@ -2,14 +2,31 @@
 #define NCURSES_DISPLAY_H
 
 #include <curses.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
 
-#include "process.h"
+#include "process_filter.h"
+#include "process_table.h"
+#include "remote.h"
 #include "system.h"
 
 namespace NCursesDisplay {
 void Display(System& system, int n = 10);
+void Display(std::vector<Remote::Source>& sources, int n = 10);
+// Shared main loop: sample draws the system window and returns the rows
+void Run(int system_height, int n,
+         const std::function<ProcessTable&(WINDOW*)>& sample);
 void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
+void DisplaySources(std::vector<Remote::Source>& sources, WINDOW* window);
+void DisplayProcesses(ProcessTable& processes, WINDOW* window, int n,
+                      ProcessTable::Column sort);
+void DisplayFilter(const std::string& query, bool editing,
+                   const ProcessFilter& filter, std::size_t matches,
+                   WINDOW* window);
+bool SelectSort(int key, ProcessTable::Column& column);
+bool EditQuery(int key, std::string& query, bool& editing);
 std::string ProgressBar(float percent);
 };  // namespace NCursesDisplay
 
@@ -0,0 +1,24 @@
+#ifndef PRESSURE_H
+#define PRESSURE_H
+
+#include <chrono>
+#include <string>
+
+/*
+Pressure stall information for one resource (cpu, memory or io)
+Each call to Stall() covers the interval since the previous call
+*/
+class Pressure {
+ public:
+  Pressure(std::string resource);
+  // Fraction of the interval in which some task stalled on the resource,
+  // or a negative value if the kernel does not report pressure
+  float Stall();
+
+ private:
+  std::string resource_;
+  long prev_total_{-1};
+  std::chrono::steady_clock::time_point prev_time_;
+};
+
+#endif
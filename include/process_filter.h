@@ -0,0 +1,48 @@
+#ifndef PROCESS_FILTER_H
+#define PROCESS_FILTER_H
+
+#include <cstddef>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "process_table.h"
+
+/*
+Precompiled matcher for the process search query.
+The query is a list of whitespace separated terms that must all match:
+  user:NAME    user name contains NAME
+  host:NAME    host name contains NAME, when watching remote agents
+  state:SR     state is one of the listed letters
+  cpu:N        CPU utilization is at least N percent
+  re:PATTERN   command matches the regular expression
+  TEXT         command contains TEXT
+*/
+class ProcessFilter {
+ public:
+  ProcessFilter() = default;
+  explicit ProcessFilter(const std::string& query);
+  bool Empty() const { return terms_.empty(); }
+  bool Valid() const { return valid_; }
+  bool Matches(ProcessTable& table, std::size_t row) const;
+  // True if every row matching this filter also matches previous, so only
+  // the rows previous selected need to be re-evaluated
+  bool Refines(const ProcessFilter& previous) const;
+
+ private:
+  enum class Kind { kCommand, kUser, kHost, kState, kCpu, kRegex };
+  struct Term {
+    Kind kind;
+    std::string text;
+    float min_cpu{0};
+    std::regex regex;
+  };
+
+  static bool MatchesTerm(const Term& term, ProcessTable& table,
+                          std::size_t row);
+
+  std::vector<Term> terms_;
+  bool valid_{true};
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+Per-tick process data stored as parallel columns.
+Row i of every column belongs to the same process; Order() holds the
+rows selected for display, in display order.
+The columns filled by Append() come from /proc/PID/stat alone. Run queue
+wait, uid, user and command are fetched the first time they are asked for;
+the details and the last wait sample are carried over to later ticks while
+the process keeps its start time and comm. Revalidate() re-reads carried
+details of the rows on screen, which exec-free argv rewrites and setuid()
+would otherwise leave stale.
+*/
+class ProcessTable {
+ public:
+  enum class Column { kPid, kCpu, kWait, kRam, kUpTime, kState, kUid };
+
+  // Number of reads made to collect the current tick
+  struct Counters {
+    long stat{0};       // /proc/PID/stat
+    long schedstat{0};  // /proc/PID/schedstat
+    long status{0};     // /proc/PID/status
+    long cmdline{0};    // /proc/PID/cmdline
+    long passwd{0};     // /etc/passwd lookups
+  };
+
+  // Rows from remote agents arrive with their details, and PIDs repeat
+  // across hosts, so merged tables clear without carrying anything over
+  void Clear(bool carry = true);
+  void Reserve(std::size_t rows);
+  void Append(int pid, float cpu, long ram, long up_time, char state,
+              long start_time, const char* comm);
+  std::size_t Size() const { return pid_.size(); }
+  Counters& Collected() { return counters_; }
+
+  int Pid(std::size_t row) const { return pid_[row]; }
+  float CpuUtilization(std::size_t row) const { return cpu_[row]; }
+  // Share of the last interval spent waiting on a run queue
+  float RunQueueWait(std::size_t row);
+  long Ram(std::size_t row) const { return ram_[row]; }  // kB resident
+  long UpTime(std::size_t row) const { return up_time_[row]; }
+  char State(std::size_t row) const { return state_[row]; }
+  long StartTime(std::size_t row) const { return start_time_[row]; }
+  int Uid(std::size_t row);
+  const std::string& User(std::size_t row);
+  const std::string& Command(std::size_t row);
+  // Drop details carried from an earlier tick so the next access re-reads
+  // them; at most once per row and tick
+  void Revalidate(std::size_t row);
+  // Uid, user and command all came unchanged from the previous tick
+  bool DetailsCarried(std::size_t row) const;
+
+  // Rows received from a remote agent come with their details and host
+  void SetRunQueueWait(std::size_t row, float wait);
+  void SetDetails(std::size_t row, int uid, std::string user,
+                  std::string command);
+  int AddHost(std::string name);
+  void SetHost(std::size_t row, int host) { host_[row] = host; }
+  bool HasHosts() const { return !hosts_.empty(); }
+  const std::string& Host(std::size_t row) const;
+
+  // Rebuild the display order from the rows for which keep(row) is true
+  void Filter(const std::function<bool(std::size_t)>& keep);
+  // Drop the selected rows for which keep(row) is false, keeping the order
+  void Refine(const std::function<bool(std::size_t)>& keep);
+  // Reorder the selected rows by a column, ties broken by PID
+  void Sort(Column column, bool descending = true);
+  const std::vector<std::size_t>& Order() const { return order_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  enum Fetched : unsigned char {
+    kUid_ = 1,
+    kUser_ = 2,
+    kCommand_ = 4,
+    kWait_ = 8,
+    kCarried_ = 16  // details from an earlier tick, not yet revalidated
+  };
+  static const unsigned char kDetails_ = kUid_ | kUser_ | kCommand_;
+  struct Details {
+    long start_time;
+    std::string comm;
+    unsigned char fetched;
+    long wait_ns;
+    Clock::time_point wait_time;
+    int uid;
+    std::string user;
+    std::string command;
+  };
+
+  template <typename T>
+  void SortBy(const std::vector<T>& column, bool descending);
+
+  std::vector<int> pid_;
+  std::vector<float> cpu_;
+  std::vector<float> wait_;
+  std::vector<long> wait_ns_;  // schedstat sample behind wait_
+  std::vector<Clock::time_point> wait_time_;
+  std::vector<long> ram_;
+  std::vector<long> up_time_;
+  std::vector<char> state_;
+  std::vector<long> start_time_;
+  std::vector<std::string> comm_;  // changes on exec, unlike start_time_
+  std::vector<unsigned char> fetched_;
+  std::vector<int> uid_;
+  std::vector<std::string> user_;
+  std::vector<std::string> command_;
+  std::vector<int> host_;
+  std::vector<std::size_t> order_;
+  std::vector<std::string> hosts_;
+
+  Counters counters_;
+  // Fetched details of the previous tick, by PID
+  std::unordered_map<int, Details> carried_;
+  // /etc/passwd names, by UID
+  std::unordered_map<int, std::string> user_names_;
+};
+
+#endif
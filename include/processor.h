@@ -19,6 +19,7 @@ class Processor {
   long guest_nice_time{0};
   long prev_busy{0};
   long prev_total{0};
+  float prev_utilization{0};
 };
 
 #endif
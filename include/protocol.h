@@ -0,0 +1,84 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "process_table.h"
+
+/*
+Binary snapshot protocol between a serving agent and a display.
+Every frame is a little-endian uint32 payload length followed by the
+payload: the host summary, the rows that changed since the previous frame
+on the same connection, and the PIDs that went away. User and command are
+only sent the first time a process is seen.
+Fractions are sent as fixed point, in units of kFractionScale.
+*/
+namespace Protocol {
+const std::uint32_t kFractionScale{10000};
+const std::uint32_t kMaxFrameSize{64 << 20};
+
+struct Summary {
+  std::string host;
+  std::string os;
+  std::string kernel;
+  std::uint32_t cpu{0};     // fraction
+  std::uint32_t memory{0};  // fraction
+  std::uint32_t load[3]{};  // 1, 5, 15 minutes, fraction
+  std::int32_t pressure[3]{-1, -1, -1};  // cpu, memory, io, fraction or -1
+  std::int32_t total_processes{0};
+  std::int32_t running_processes{0};
+  std::int64_t up_time{0};  // seconds
+  std::int32_t clock_ticks{100};
+};
+
+struct Row {
+  std::int32_t pid{0};
+  std::int64_t start_time{0};  // clock ticks after boot
+  std::uint32_t cpu{0};        // fraction
+  std::uint32_t wait{0};       // fraction
+  std::int64_t ram{0};         // kB
+  char state{'?'};
+  std::int32_t uid{-1};
+  std::string user;
+  std::string command;
+};
+
+std::uint32_t Fraction(float value);
+
+// Sender side of one connection: remembers what the peer already has
+class Encoder {
+ public:
+  std::string Frame(const Summary& summary, ProcessTable& processes);
+
+ private:
+  std::unordered_map<std::int32_t, Row> sent_;
+};
+
+// Receiver side of one connection: rebuilds the peer's state from frames
+class Decoder {
+ public:
+  // Returns false if the stream is malformed
+  bool Feed(const char* data, std::size_t size);
+  void Reset();
+  bool Ready() const { return ready_; }
+  const Summary& System() const { return summary_; }
+  const std::unordered_map<std::int32_t, Row>& Rows() const { return rows_; }
+  // Rows added or updated by the last frame applied
+  std::size_t Changed() const { return changed_; }
+
+ private:
+  bool Apply(const char* payload, std::size_t size);
+
+  std::string pending_;
+  bool ready_{false};
+  Summary summary_;
+  std::unordered_map<std::int32_t, Row> rows_;
+  std::size_t changed_{0};
+};
+};  // namespace Protocol
+
+#endif
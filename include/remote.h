@@ -0,0 +1,81 @@
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include <chrono>
+#include <sys/socket.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "process_table.h"
+#include "protocol.h"
+#include "system.h"
+
+/*
+Agent and console ends of the snapshot stream.
+Endpoints are either unix:/path/to/socket or host:port; an empty host
+listens on 127.0.0.1 and connects to localhost. The stream is neither
+authenticated nor encrypted and holds every command line, which may carry
+secrets, so agents should only listen on interfaces the viewers trust.
+*/
+namespace Remote {
+int Listen(const std::string& endpoint);
+
+// One address an endpoint resolves to; host names may yield several
+struct Address {
+  sockaddr_storage storage;
+  socklen_t length;
+};
+std::vector<Address> Resolve(const std::string& endpoint);
+// Starts a non-blocking connect; the socket turns writable once it completes
+int Connect(const Address& address);
+
+// Sample the local system once per second and stream it to every client.
+// Returns only if the endpoint cannot be opened.
+int Serve(System& system, const std::string& endpoint,
+          const std::string& host);
+
+// One agent a console is watching; reconnects when the agent goes away,
+// trying each address of the endpoint in turn and backing off from one
+// second to half a minute while none of them can be reached
+class Source {
+ public:
+  Source(std::string endpoint);
+  Source(const Source&) = delete;
+  Source& operator=(const Source&) = delete;
+  Source(Source&& other);
+  ~Source();
+
+  // Read whatever the agent sent since the last call, without blocking
+  void Poll();
+  bool Connected() const { return fd_ >= 0 && !connecting_; }
+  bool Connecting() const { return connecting_; }
+  const std::string& Endpoint() const { return endpoint_; }
+  const Protocol::Decoder& State() const { return decoder_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  static constexpr std::chrono::seconds kMinBackoff{1};
+  static constexpr std::chrono::seconds kMaxBackoff{30};
+  static constexpr std::chrono::seconds kConnectTimeout{5};
+
+  void Disconnect();
+  bool ConnectNext();
+  void Retry();
+
+  std::string endpoint_;
+  int fd_{-1};
+  bool connecting_{false};
+  std::vector<Address> addresses_;
+  std::size_t next_address_{0};
+  // Next attempt while disconnected, or when a pending connect gives up
+  Clock::time_point deadline_{};
+  std::chrono::seconds backoff_{kMinBackoff};
+  Protocol::Decoder decoder_;
+};
+
+// Merge the latest rows of every source into one table, tagged by host
+void Merge(std::vector<Source>& sources, ProcessTable& processes);
+};  // namespace Remote
+
+#endif
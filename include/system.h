@@ -4,25 +4,34 @@
 #include <string>
 #include <vector>
 
-#include "process.h"
+#include "linux_parser.h"
+#include "pressure.h"
+#include "process_table.h"
 #include "processor.h"
 
 class System {
  public:
   System();
-  Processor& Cpu();                   // DONE: See src/system.cpp
-  std::vector<Process>& Processes();  // DONE: See src/system.cpp
-  float MemoryUtilization();          // DONE: See src/system.cpp
-  long UpTime();                      // DONE: See src/system.cpp
-  int TotalProcesses();               // DONE: See src/system.cpp
-  int RunningProcesses();             // DONE: See src/system.cpp
-  std::string Kernel();               // DONE: See src/system.cpp
-  std::string OperatingSystem();      // DONE: See src/system.cpp
+  Processor& Cpu();                    // DONE: See src/system.cpp
+  ProcessTable& Processes();           // DONE: See src/system.cpp
+  float MemoryUtilization();           // DONE: See src/system.cpp
+  long UpTime();                       // DONE: See src/system.cpp
+  int TotalProcesses();                // DONE: See src/system.cpp
+  int RunningProcesses();              // DONE: See src/system.cpp
+  std::string Kernel();                // DONE: See src/system.cpp
+  std::string OperatingSystem();       // DONE: See src/system.cpp
+  LinuxParser::LoadAvg LoadAverage();  // DONE: See src/system.cpp
+  Pressure& CpuPressure();             // DONE: See src/system.cpp
+  Pressure& MemoryPressure();          // DONE: See src/system.cpp
+  Pressure& IoPressure();              // DONE: See src/system.cpp
 
   // DONE: Define any necessary private members
  private:
   Processor cpu_ = {};
-  std::vector<Process> processes_ = {};
+  ProcessTable processes_ = {};
+  Pressure cpu_pressure_{"cpu"};
+  Pressure memory_pressure_{"memory"};
+  Pressure io_pressure_{"io"};
 };
 
 #endif
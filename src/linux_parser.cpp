@@ -1,11 +1,15 @@
 #include "linux_parser.h"
 #include <dirent.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 using std::stof;
@@ -14,6 +18,159 @@ using std::string;
 using std::to_string;
 using std::vector;
 
+namespace {
+string proc_directory{"/proc/"};
+
+// Larger values are treated as corrupt, so that sums of a few fields
+// cannot overflow
+const long kMaxField{LONG_MAX / 16};
+
+// Read at most size - 1 bytes of a file into a caller-owned buffer and
+// terminate it with '\0'. Returns the number of bytes read or -1.
+long ReadFile(const char* path, char* buffer, size_t size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  ssize_t length = read(fd, buffer, size - 1);
+  close(fd);
+  if (length < 0) return -1;
+  buffer[length] = '\0';
+  return length;
+}
+
+// Read /proc/PID/<file> the same way; -1 once the process is gone
+long ReadProcessFile(int pid, const string& filename, char* buffer,
+                     size_t size) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s%d%s", LinuxParser::ProcDirectory().c_str(),
+           pid, filename.c_str());
+  return ReadFile(path, buffer, size);
+}
+
+// Parse one decimal field and advance the cursor past it. Unlike stol this
+// never throws: missing, out of range or implausible values return false.
+bool ParseLong(const char*& cursor, long& value) {
+  // Unlike strtol, do not run on into the next line
+  const char* start = cursor;
+  while (*start == ' ' || *start == '\t') ++start;
+  if (!isdigit((unsigned char)*start) && *start != '-') return false;
+  char* end;
+  errno = 0;
+  long parsed = strtol(start, &end, 10);
+  if (end == start || errno == ERANGE) return false;
+  if (parsed > kMaxField || parsed < -kMaxField) return false;
+  cursor = end;
+  value = parsed;
+  return true;
+}
+}  // namespace
+
+// DONE: Parse the aggregate "cpu" line at the start of /proc/stat.
+// Kernels older than 2.6.33 report fewer than ten fields; the missing
+// ones are left at zero, but user, nice, system and idle are required.
+bool LinuxParser::ParseCpuTimes(const char* buffer, CpuTimes& times) {
+  if (strncmp(buffer, "cpu ", 4) != 0) return false;
+  const char* cursor = buffer + 4;
+  long* fields[] = {&times.user,    &times.nice,  &times.system,
+                    &times.idle,    &times.iowait, &times.irq,
+                    &times.softirq, &times.steal, &times.guest,
+                    &times.guest_nice};
+  int parsed{0};
+  for (long* field : fields) {
+    *field = 0;
+    // Stop at the end of the first line
+    while (*cursor == ' ') ++cursor;
+    if (*cursor == '\n' || *cursor == '\0') continue;
+    if (!ParseLong(cursor, *field) || *field < 0) return false;
+    ++parsed;
+  }
+  return parsed >= 4;
+}
+
+// DONE: Parse /proc/PID/stat. (2) comm may contain spaces and parentheses,
+// so it runs from the first '(' to the last ')' and fields are counted
+// from there.
+bool LinuxParser::ParseProcStat(const char* buffer, ProcStat& stat) {
+  const char* comm = strchr(buffer, '(');
+  const char* cursor = strrchr(buffer, ')');
+  if (comm == nullptr || cursor == nullptr || cursor < comm) return false;
+  if (cursor[1] != ' ' || cursor[2] == '\0') return false;
+  size_t comm_length = cursor - (comm + 1);
+  if (comm_length > kCommLength - 1) comm_length = kCommLength - 1;
+  cursor += 2;
+  char const state = *cursor++;
+
+  long active_jiffies{0}, start_time{0}, rss{0};
+  for (int field = 4; field <= 24; ++field) {
+    long value;
+    if (!ParseLong(cursor, value)) return false;  // truncated line
+    if (field >= 14 && field <= 17) active_jiffies += value;
+    if (field == 22) start_time = value;
+    if (field == 24) rss = value;
+  }
+  memcpy(stat.comm, comm + 1, comm_length);
+  stat.comm[comm_length] = '\0';
+  stat.state = state;
+  stat.active_jiffies = active_jiffies;
+  stat.start_time = start_time;
+  stat.rss = rss;
+  return true;
+}
+
+// DONE: Parse the MemTotal and MemFree lines of /proc/meminfo
+bool LinuxParser::ParseMemInfo(const char* buffer, long& total, long& free) {
+  bool has_total{false}, has_free{false};
+  for (const char* line = buffer; *line != '\0';) {
+    const char* cursor = line;
+    if (strncmp(line, "MemTotal:", 9) == 0) {
+      cursor += 9;
+      has_total = ParseLong(cursor, total);
+    } else if (strncmp(line, "MemFree:", 8) == 0) {
+      cursor += 8;
+      has_free = ParseLong(cursor, free);
+    }
+    if (has_total && has_free) return true;
+    line = strchr(line, '\n');
+    if (line == nullptr) break;
+    ++line;
+  }
+  return false;
+}
+
+// DONE: Parse the first number after "key" at the start of a line in
+// /proc/PID/status, e.g. "Uid:" or "VmSize:"
+bool LinuxParser::ParseStatusField(const char* buffer, const char* key,
+                                   long& value) {
+  size_t const key_length{strlen(key)};
+  for (const char* line = buffer; *line != '\0';) {
+    if (strncmp(line, key, key_length) == 0) {
+      const char* cursor = line + key_length;
+      return ParseLong(cursor, value);
+    }
+    line = strchr(line, '\n');
+    if (line == nullptr) break;
+    ++line;
+  }
+  return false;
+}
+
+// DONE: Turn the NUL separated arguments of /proc/PID/cmdline into one
+// space separated line, in place. Returns the new length.
+size_t LinuxParser::ParseCmdline(char* buffer, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    if (buffer[i] == '\0' || buffer[i] == '\n') buffer[i] = ' ';
+  }
+  while (length > 0 && buffer[length - 1] == ' ') --length;
+  buffer[length] = '\0';
+  return length;
+}
+
+const string& LinuxParser::ProcDirectory() { return proc_directory; }
+
+void LinuxParser::SetProcDirectory(string directory) {
+  if (directory.empty() || directory.back() != '/') directory += '/';
+  proc_directory = std::move(directory);
+}
+
 // DONE: An example of how to read data from the filesystem
 string LinuxParser::OperatingSystem() {
   string line;
@@ -41,7 +198,7 @@ string LinuxParser::OperatingSystem() {
 string LinuxParser::Kernel() {
   string os, version, kernel;
   string line;
-  std::ifstream stream(kProcDirectory + kVersionFilename);
+  std::ifstream stream(ProcDirectory() + kVersionFilename);
   if (stream.is_open()) {
     std::getline(stream, line);
     std::istringstream linestream(line);
@@ -53,7 +210,8 @@ string LinuxParser::Kernel() {
 // BONUS: Update this to use std::filesystem
 vector<int> LinuxParser::Pids() {
   vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
+  DIR* directory = opendir(ProcDirectory().c_str());
+  if (directory == nullptr) return pids;
   struct dirent* file;
   while ((file = readdir(directory)) != nullptr) {
     // Is this a directory?
@@ -61,8 +219,9 @@ vector<int> LinuxParser::Pids() {
       // Is every character of the name a digit?
       string filename(file->d_name);
       if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
-        pids.push_back(pid);
+        const char* cursor = file->d_name;
+        long pid;
+        if (ParseLong(cursor, pid) && pid <= INT_MAX) pids.push_back(pid);
       }
     }
   }
@@ -71,46 +230,26 @@ vector<int> LinuxParser::Pids() {
 }
 
 // DONE: Read and return the system memory utilization
+// Returns 0 if /proc/meminfo cannot be read or reports no memory
 float LinuxParser::MemoryUtilization() {
-  string line;
-  string key, value;
-  float mem_total, mem_used;
-  // /proc/meminfo
-  std::ifstream stream(kProcDirectory + kMeminfoFilename);
-  if (stream.is_open()) {
-    // Parse line-by-line
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> key >> value;
-      if (key == "MemTotal:") mem_total = std::stof(value);
-
-      if (key == "MemFree:") {
-        // Used memory = Total memory - Free Memory
-        mem_used = mem_total - std::stof(value);
-        break;
-      }
-    }
-  }
-
-  // To debug:std::cout << mem_total << "\t" << mem_used << "\n";
-
-  // If mem_total == 0, throw error
-  bool mem_total_zero{false};
-  if (mem_total == 0) {
-    throw std::range_error("Memory Total = 0");
-    mem_total_zero = true;
-    assert(mem_total_zero);
-  }
-  // Utilization = Used memory / Total Memory
-  return (mem_used / mem_total);
-  // return (0.0);
+  char path[256];
+  char buffer[4096];
+  long mem_total, mem_free;
+  snprintf(path, sizeof(path), "%s%s", ProcDirectory().c_str(),
+           kMeminfoFilename.c_str());
+  if (ReadFile(path, buffer, sizeof(buffer)) <= 0) return 0;
+  if (!ParseMemInfo(buffer, mem_total, mem_free)) return 0;
+  if (mem_total <= 0 || mem_free < 0 || mem_free > mem_total) return 0;
+
+  // Utilization = (Total memory - Free Memory) / Total Memory
+  return (float)(mem_total - mem_free) / (float)mem_total;
 }
 
 // DONE: Read and return the system uptime
 long LinuxParser::UpTime() {
   long up_time = 0;
   string line;
-  std::ifstream stream(kProcDirectory + kUptimeFilename);
+  std::ifstream stream(ProcDirectory() + kUptimeFilename);
   if (stream.is_open()) {
     std::getline(stream, line);
     std::istringstream linestream(line);
@@ -122,7 +261,8 @@ long LinuxParser::UpTime() {
 
 // DONE: Read and return the number of jiffies for the system
 long LinuxParser::Jiffies() {
-  vector<string> system_jiffies = CpuUtilization();
+  CpuTimes times;
+  if (!SystemCpuTimes(times)) return 0;
 
   // According to:
   // //
@@ -130,29 +270,18 @@ long LinuxParser::Jiffies() {
   // Total Time = Busy + Idle =
   //		    = user (1) + nice (2) + system (3) + irq (6) +
   //		    + softirq (7) + steal (8) + idel (4) + iowait (5)
-  return (stol(system_jiffies[0]) + stol(system_jiffies[1]) +
-          stol(system_jiffies[2]) + stol(system_jiffies[5]) +
-          stol(system_jiffies[6]) + stol(system_jiffies[7]) +
-          stol(system_jiffies[3]) + stol(system_jiffies[4]));
+  return (times.user + times.nice + times.system + times.irq + times.softirq +
+          times.steal + times.idle + times.iowait);
 }
 
-// DONE: Read and return the number of active jiffies for a PID
-long LinuxParser::ActiveJiffies(int pid) {
-  string line, values;
-  vector<string> stat_values;
-
-  // /proc/PID/stat
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
-
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-
-    while (linestream >> values) stat_values.push_back(values);
-  }
-  // (14) utime +  (15) stime + (16) cutime + (17) cstime
-  return (stol(stat_values[13]) + stol(stat_values[14]) +
-          stol(stat_values[15]) + stol(stat_values[16]));
+// DONE: Read the aggregate CPU times from the first line of /proc/stat
+bool LinuxParser::SystemCpuTimes(CpuTimes& times) {
+  char path[256];
+  char buffer[4096];
+  snprintf(path, sizeof(path), "%s%s", ProcDirectory().c_str(),
+           kStatFilename.c_str());
+  if (ReadFile(path, buffer, sizeof(buffer)) <= 0) return false;
+  return ParseCpuTimes(buffer, times);
 }
 
 // TODO: Read and return the number of active jiffies for the system
@@ -163,40 +292,13 @@ long LinuxParser::ActiveJiffies() { return 0; }
 // Not implemented, as this is not needed
 long LinuxParser::IdleJiffies() { return 0; }
 
-// DONE: Read and return CPU utilization
-vector<string> LinuxParser::CpuUtilization() {
-  string line;
-  string cpu_line_values;
-  vector<string> cpu_values;
-
-  std::ifstream stream(kProcDirectory + kStatFilename);
-
-  if (stream.is_open()) {
-    // The first line is the "cpu" line
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-
-    // First field "cpu" discard
-    linestream >> cpu_line_values;
-    // std::cout << cpu_line_values;;
-    // Read the rest of the line to the vector
-    while (linestream >> cpu_line_values) cpu_values.push_back(cpu_line_values);
-  }
-  /* For debug
-  for (int i = 0; i < cpu_values.size(); i++)
-          std::cout << cpu_values[i] << "\t";
-  std::cout << "\n";
-  */
-  return cpu_values;
-}
-
 // DONE: Read and return the total number of processes
 int LinuxParser::TotalProcesses() {
   string line;
   string key;
   int num_processes = 0, value;
   // /proc/stat
-  std::ifstream stream(kProcDirectory + kStatFilename);
+  std::ifstream stream(ProcDirectory() + kStatFilename);
 
   if (stream.is_open()) {
     // Parse line-by-line
@@ -219,7 +321,7 @@ int LinuxParser::RunningProcesses() {
   string key;
   int running_processes = 0, value;
   // /proc/stat
-  std::ifstream stream(kProcDirectory + kStatFilename);
+  std::ifstream stream(ProcDirectory() + kStatFilename);
 
   if (stream.is_open()) {
     // Parse line-by-line
@@ -237,68 +339,31 @@ int LinuxParser::RunningProcesses() {
 
 // DONE: Read and return the command associated with a process
 string LinuxParser::Command(int pid) {
-  string line;
-
-  // /proc/PID/cmdline
-  std::ifstream stream(kProcDirectory + to_string(pid) + kCmdlineFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    return line;
-  }
-  // If file does not open
-  return string();
-}
-
-// DONE: Read and return the memory used by a process
-string LinuxParser::Ram(int pid) {
-  string line;
-  string key, value;
-  long RAM;
-
-  // /proc/PID/status
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatusFilename);
-  if (stream.is_open()) {
-    // Parse line-by-line
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> key >> value;
-      // VmSize is RAM
-      if (key == "VmSize:") {
-        RAM = std::stol(value) / 1000;  // or 1024
-        return to_string(RAM);
-      }
-    }
-  }
-  // If VmSize cannot be read
-  return string();
-  ;
+  // /proc/PID/cmdline, truncated to the buffer
+  char buffer[4096];
+  long length = ReadProcessFile(pid, kCmdlineFilename, buffer, sizeof(buffer));
+  // Kernel threads have an empty cmdline, exited processes none at all
+  if (length <= 0) return string();
+  return string(buffer, ParseCmdline(buffer, length));
 }
 
 // DONE: Read and return the user ID associated with a process
 string LinuxParser::Uid(int pid) {
-  string line;
-  string key, value;
-  string uid;
   // /proc/PID/status
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatusFilename);
-  if (stream.is_open()) {
-    // Parse line-by-line
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> key >> value;
-      ;
-      if (key == "Uid:") uid = value;
-    }
-  }
-  // std::cout << "UID:" << uid << "\t";
-  return uid;
+  char buffer[4096];
+  long uid;
+  if (ReadProcessFile(pid, kStatusFilename, buffer, sizeof(buffer)) <= 0)
+    return string();
+  if (!ParseStatusField(buffer, "Uid:", uid) || uid < 0 || uid > INT_MAX)
+    return string();
+  return to_string(uid);
 }
 
-// DONE: Read and return the user associated with a process
-string LinuxParser::User(int pid) {
+// DONE: Read and return the name /etc/passwd gives a user ID
+string LinuxParser::UserName(int uid) {
   string line;
-  string user, mode, uid;
-  string proc_uid = Uid(pid);
+  string user, mode, passwd_uid;
+  string proc_uid = to_string(uid);
 
   // /etc/passwd
   std::ifstream stream(kPasswordPath);
@@ -307,9 +372,9 @@ string LinuxParser::User(int pid) {
     while (std::getline(stream, line)) {
       std::replace(line.begin(), line.end(), ':', ' ');
       std::istringstream linestream(line);
-      linestream >> user >> mode >> uid;
+      linestream >> user >> mode >> passwd_uid;
       // std::cout << user << "\t";
-      if (uid == proc_uid) return (user);
+      if (passwd_uid == proc_uid) return (user);
     }
   }
 
@@ -317,22 +382,62 @@ string LinuxParser::User(int pid) {
   return string();
 }
 
-// DONE: Read and return the uptime of a process
-long LinuxParser::UpTime(int pid) {
-  string line, values;
-  vector<string> stat_values;
+// DONE: Read state, CPU time, start time and RSS in one pass over
+// /proc/PID/stat, without intermediate strings
+bool LinuxParser::ProcessStat(int pid, ProcStat& stat) {
+  char buffer[1024];
+  if (ReadProcessFile(pid, kStatFilename, buffer, sizeof(buffer)) <= 0)
+    return false;
+  return ParseProcStat(buffer, stat);
+}
 
-  // /proc/PID/stat
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
+// DONE: Read the 1, 5 and 15 minute load averages from /proc/loadavg
+bool LinuxParser::LoadAverage(LoadAvg& load) {
+  char path[256];
+  char buffer[128];
+  snprintf(path, sizeof(path), "%s%s", ProcDirectory().c_str(),
+           kLoadavgFilename.c_str());
+  if (ReadFile(path, buffer, sizeof(buffer)) <= 0) return false;
+
+  char* cursor = buffer;
+  char* end;
+  float* fields[] = {&load.one, &load.five, &load.fifteen};
+  for (float* field : fields) {
+    *field = strtof(cursor, &end);
+    if (end == cursor) return false;
+    cursor = end;
+  }
+  return true;
+}
 
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
+// DONE: Read the "some" stall total from /proc/pressure/<resource>
+// some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+bool LinuxParser::PressureTotal(const string& resource, long& total) {
+  char path[256];
+  char buffer[256];
+  snprintf(path, sizeof(path), "%s%s%s", ProcDirectory().c_str(),
+           kPressureDirectory.c_str(), resource.c_str());
+  // Kernels without CONFIG_PSI have no /proc/pressure
+  if (ReadFile(path, buffer, sizeof(buffer)) <= 0) return false;
+  if (strncmp(buffer, "some ", 5) != 0) return false;
+
+  char* newline = strchr(buffer, '\n');
+  if (newline != nullptr) *newline = '\0';
+  const char* cursor = strstr(buffer, "total=");
+  if (cursor == nullptr) return false;
+  cursor += 6;
+  return ParseLong(cursor, total) && total >= 0;
+}
 
-    while (linestream >> values) stat_values.push_back(values);
-    // (22) starttime =  stat_values[21]
-    return UpTime() - (stol(stat_values[21]) / sysconf(_SC_CLK_TCK));
-  }
-  // If starttime cannot be read for any reason
-  return 0;
+// DONE: Read the run queue wait from /proc/PID/schedstat
+// (1) time on CPU (2) time waiting on a run queue (3) timeslices
+bool LinuxParser::RunQueueWait(int pid, long& wait) {
+  char buffer[128];
+  // Also missing when the kernel is built without CONFIG_SCHED_INFO
+  if (ReadProcessFile(pid, kSchedstatFilename, buffer, sizeof(buffer)) <= 0)
+    return false;
+
+  const char* cursor = buffer;
+  long on_cpu;
+  return ParseLong(cursor, on_cpu) && ParseLong(cursor, wait) && wait >= 0;
 }
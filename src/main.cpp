@@ -1,7 +1,69 @@
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
 #include "ncurses_display.h"
+#include "remote.h"
 #include "system.h"
 
-int main() {
+namespace {
+void Usage() {
+  std::cerr << "usage: monitor [--proc-root DIR] [--serve ENDPOINT "
+               "[--host NAME]]\n"
+               "       monitor --connect ENDPOINT[,ENDPOINT...]\n"
+               "ENDPOINT is unix:/path or host:port; :port means 127.0.0.1\n"
+               "The stream is unauthenticated and carries every command\n"
+               "line: serve on 0.0.0.0:port or [::]:port only on a trusted\n"
+               "network\n";
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string serve, host;
+  std::vector<Remote::Source> sources;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const option{argv[i]};
+    if (i + 1 == argc) {
+      Usage();
+      return 2;
+    }
+    std::string const value{argv[++i]};
+    if (option == "--proc-root") {
+      LinuxParser::SetProcDirectory(value);
+    } else if (option == "--serve") {
+      serve = value;
+    } else if (option == "--host") {
+      host = value;
+    } else if (option == "--connect") {
+      size_t begin{0};
+      while (begin <= value.size()) {
+        size_t end{value.find(',', begin)};
+        if (end == std::string::npos) end = value.size();
+        if (end > begin) sources.emplace_back(value.substr(begin, end - begin));
+        begin = end + 1;
+      }
+    } else {
+      Usage();
+      return 2;
+    }
+  }
+
+  if (!sources.empty()) {
+    NCursesDisplay::Display(sources);
+    return 0;
+  }
+
   System system;
+  if (!serve.empty()) {
+    if (host.empty()) {
+      char name[256]{};
+      gethostname(name, sizeof(name) - 1);
+      host = name;
+    }
+    return Remote::Serve(system, serve, host);
+  }
   NCursesDisplay::Display(system);
-}
\ No newline at end of file
+}
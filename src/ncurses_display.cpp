@@ -1,16 +1,34 @@
 #include <curses.h>
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
-#include <thread>
+#include <utility>
 #include <vector>
 
 #include "format.h"
+#include "linux_parser.h"
 #include "ncurses_display.h"
+#include "pressure.h"
+#include "process_filter.h"
+#include "process_table.h"
+#include "protocol.h"
+#include "remote.h"
 #include "system.h"
 
 using std::string;
 using std::to_string;
 
+namespace {
+// Identifiers sort ascending, measurements largest first
+bool Descending(ProcessTable::Column column) {
+  return column != ProcessTable::Column::kPid &&
+         column != ProcessTable::Column::kUid;
+}
+}  // namespace
+
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
 std::string NCursesDisplay::ProgressBar(float percent) {
@@ -30,80 +48,312 @@ std::string NCursesDisplay::ProgressBar(float percent) {
 
 void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
   int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
+  mvwprintw(window, ++row, 2, "%s",
+            ("OS: " + system.OperatingSystem()).c_str());
+  mvwprintw(window, ++row, 2, "%s", ("Kernel: " + system.Kernel()).c_str());
   mvwprintw(window, ++row, 2, "CPU: ");
   wattron(window, COLOR_PAIR(1));
   mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
+  wprintw(window, "%s", ProgressBar(system.Cpu().Utilization()).c_str());
   wattroff(window, COLOR_PAIR(1));
   mvwprintw(window, ++row, 2, "Memory: ");
   wattron(window, COLOR_PAIR(1));
   mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
+  wprintw(window, "%s", ProgressBar(system.MemoryUtilization()).c_str());
   wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
+  LinuxParser::LoadAvg load{system.LoadAverage()};
+  mvwprintw(window, ++row, 2, "%s",
+            ("Load Average: " + to_string(load.one).substr(0, 4) + " " +
+             to_string(load.five).substr(0, 4) + " " +
+             to_string(load.fifteen).substr(0, 4))
+                .c_str());
+  // Share of the last interval in which some task stalled
+  string pressure{"Pressure: "};
+  std::pair<string, Pressure*> const resources[]{
+      {"cpu", &system.CpuPressure()},
+      {"memory", &system.MemoryPressure()},
+      {"io", &system.IoPressure()}};
+  for (auto const& resource : resources) {
+    float stall{resource.second->Stall()};
+    pressure += resource.first + " ";
+    pressure += stall < 0 ? "n/a" : to_string(stall * 100).substr(0, 4) + "%";
+    pressure += "  ";
+  }
+  mvwprintw(window, ++row, 2, "%s", pressure.c_str());
+  mvwprintw(
+      window, ++row, 2, "%s",
+      ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
   mvwprintw(
-      window, ++row, 2,
+      window, ++row, 2, "%s",
       ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
+  mvwprintw(window, ++row, 2, "%s",
             ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
   wrefresh(window);
 }
 
-void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
+// One line per agent in remote mode
+void NCursesDisplay::DisplaySources(std::vector<Remote::Source>& sources,
+                                   WINDOW* window) {
+  int row{0};
+  for (Remote::Source const& source : sources) {
+    const Protocol::Summary& summary{source.State().System()};
+    string line;
+    if (source.Connecting()) {
+      line = source.Endpoint() + ": connecting";
+    } else if (!source.Connected()) {
+      line = source.Endpoint() + ": disconnected";
+    } else if (!source.State().Ready()) {
+      line = source.Endpoint() + ": waiting for data";
+    } else {
+      auto percent = [](std::int64_t fraction) {
+        if (fraction < 0) return string("n/a");
+        return to_string(fraction * 100.0 / Protocol::kFractionScale)
+                   .substr(0, 4) +
+               "%";
+      };
+      auto load = [](std::uint32_t fraction) {
+        return to_string((double)fraction / Protocol::kFractionScale)
+            .substr(0, 4);
+      };
+      line = summary.host + "  CPU " + percent(summary.cpu) + "  Memory " +
+             percent(summary.memory) + "  Load " + load(summary.load[0]) +
+             " " + load(summary.load[1]) + " " + load(summary.load[2]) +
+             "  Pressure " + percent(summary.pressure[0]) + " " +
+             percent(summary.pressure[1]) + " " +
+             percent(summary.pressure[2]) + "  Running " +
+             to_string(summary.running_processes) + "  Up " +
+             Format::ElapsedTime(summary.up_time);
+    }
+    mvwprintw(window, ++row, 2, "%s",
+              line.substr(0, window->_maxx - 3).c_str());
+  }
+  wrefresh(window);
+}
+
+void NCursesDisplay::DisplayProcesses(ProcessTable& processes, WINDOW* window,
+                                      int n, ProcessTable::Column sort) {
   int row{0};
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
-  int const ram_column{26};
-  int const time_column{35};
-  int const command_column{46};
+  int const wait_column{24};
+  int const ram_column{33};
+  int const time_column{42};
+  int const host_column{53};
+  // The merged view of several agents adds a HOST column
+  int const command_column{processes.HasHosts() ? 66 : 53};
   wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column, "PID");
-  mvwprintw(window, row, user_column, "USER");
-  mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
+  // The sort column is shown underlined
+  auto header = [&](ProcessTable::Column column, int x, const char* label) {
+    if (column == sort) wattron(window, A_UNDERLINE);
+    mvwprintw(window, row, x, "%s", label);
+    wattroff(window, A_UNDERLINE);
+  };
+  ++row;
+  header(ProcessTable::Column::kPid, pid_column, "PID");
+  header(ProcessTable::Column::kUid, user_column, "USER");
+  header(ProcessTable::Column::kCpu, cpu_column, "CPU[%]");
+  header(ProcessTable::Column::kWait, wait_column, "WAIT[%]");
+  header(ProcessTable::Column::kRam, ram_column, "RAM[MB]");
+  header(ProcessTable::Column::kUpTime, time_column, "TIME+");
+  if (processes.HasHosts()) mvwprintw(window, row, host_column, "HOST");
   mvwprintw(window, row, command_column, "COMMAND");
   wattroff(window, COLOR_PAIR(2));
-  for (int i = 0; i < n; ++i) {
-    mvwprintw(window, ++row, pid_column, to_string(processes[i].Pid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].User().c_str());
-    float cpu = processes[i].CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              processes[i].Command().substr(0, window->_maxx - 46).c_str());
+  std::vector<std::size_t> const& order = processes.Order();
+  for (int i = 0; i < n && i < (int)order.size(); ++i) {
+    std::size_t const p = order[i];
+    processes.Revalidate(p);
+    mvwprintw(window, ++row, pid_column, "%d", processes.Pid(p));
+    mvwprintw(window, row, user_column, "%s", processes.User(p).c_str());
+    float cpu = processes.CpuUtilization(p) * 100;
+    mvwprintw(window, row, cpu_column, "%s",
+              to_string(cpu).substr(0, 4).c_str());
+    float wait = processes.RunQueueWait(p) * 100;
+    mvwprintw(window, row, wait_column, "%s",
+              to_string(wait).substr(0, 4).c_str());
+    mvwprintw(window, row, ram_column, "%ld", processes.Ram(p) / 1024);
+    mvwprintw(window, row, time_column, "%s",
+              Format::ElapsedTime(processes.UpTime(p)).c_str());
+    if (processes.HasHosts())
+      mvwprintw(window, row, host_column, "%s",
+                processes.Host(p).substr(0, 12).c_str());
+    mvwprintw(window, row, command_column, "%s",
+              processes.Command(p)
+                  .substr(0, window->_maxx - command_column)
+                  .c_str());
+  }
+
+  // Reads made this tick, on the bottom border
+  ProcessTable::Counters const& reads = processes.Collected();
+  string const counters{" reads: stat " + to_string(reads.stat) +
+                        " schedstat " + to_string(reads.schedstat) +
+                        " status " + to_string(reads.status) + " cmdline " +
+                        to_string(reads.cmdline) + " passwd " +
+                        to_string(reads.passwd) + " "};
+  mvwprintw(window, window->_maxy,
+            std::max(2, window->_maxx - 1 - (int)counters.size()), "%s",
+            counters.c_str());
+}
+
+// Prompt on the last line of the process window
+void NCursesDisplay::DisplayFilter(const std::string& query, bool editing,
+                                   const ProcessFilter& filter,
+                                   std::size_t matches, WINDOW* window) {
+  int const row{window->_maxy - 1};
+  string line;
+  if (editing)
+    line = "/" + query;
+  else if (!filter.Empty())
+    line = "filter: " + query + " (" + to_string(matches) + " matches)";
+  else
+    line = "press / to filter; p, u, c, w, m, t to sort";
+  if (!filter.Valid()) line += "  [incomplete]";
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, row, 2, "%s", line.substr(0, window->_maxx - 3).c_str());
+  wattroff(window, COLOR_PAIR(2));
+}
+
+// Returns true if the key picked a sort column
+bool NCursesDisplay::SelectSort(int key, ProcessTable::Column& column) {
+  switch (key) {
+    case 'p':
+      column = ProcessTable::Column::kPid;
+      return true;
+    case 'c':
+      column = ProcessTable::Column::kCpu;
+      return true;
+    case 'w':
+      column = ProcessTable::Column::kWait;
+      return true;
+    case 'm':
+      column = ProcessTable::Column::kRam;
+      return true;
+    case 't':
+      column = ProcessTable::Column::kUpTime;
+      return true;
+    case 'u':
+      column = ProcessTable::Column::kUid;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if the query text changed
+bool NCursesDisplay::EditQuery(int key, std::string& query, bool& editing) {
+  if (!editing) {
+    if (key == '/') editing = true;
+    return false;
+  }
+  switch (key) {
+    case '\n':
+    case KEY_ENTER:
+      editing = false;
+      return false;
+    case 27:  // Escape clears the filter
+      editing = false;
+      query.clear();
+      return true;
+    case KEY_BACKSPACE:
+    case 127:
+    case '\b':
+      if (query.empty()) return false;
+      query.pop_back();
+      return true;
+    default:
+      if (key < ' ' || key > '~') return false;
+      query += static_cast<char>(key);
+      return true;
   }
 }
 
 void NCursesDisplay::Display(System& system, int n) {
+  Run(11, n, [&](WINDOW* window) -> ProcessTable& {
+    DisplaySystem(system, window);
+    return system.Processes();
+  });
+}
+
+void NCursesDisplay::Display(std::vector<Remote::Source>& sources, int n) {
+  ProcessTable processes;
+  Run(2 + sources.size(), n, [&](WINDOW* window) -> ProcessTable& {
+    for (Remote::Source& source : sources) source.Poll();
+    DisplaySources(sources, window);
+    Remote::Merge(sources, processes);
+    return processes;
+  });
+}
+
+void NCursesDisplay::Run(
+    int system_height, int n,
+    const std::function<ProcessTable&(WINDOW*)>& sample) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
   start_color();  // enable color
+  keypad(stdscr, true);
+  set_escdelay(25);
 
   int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
+  WINDOW* system_window = newwin(system_height, x_max - 1, 0, 0);
   WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
+      newwin(4 + n, x_max - 1, system_window->_maxy + 1, 0);
+
+  // Keystrokes re-filter the rows already in memory; /proc is only read
+  // once per sampling interval
+  auto const interval{std::chrono::seconds(1)};
+  auto next_sample{std::chrono::steady_clock::now()};
+  ProcessTable* processes{nullptr};
+  ProcessFilter filter;
+  ProcessTable::Column sort{ProcessTable::Column::kCpu};
+  string query;
+  bool editing{false};
+  auto matches = [&](std::size_t row) {
+    return filter.Matches(*processes, row);
+  };
 
   while (1) {
     init_pair(1, COLOR_BLUE, COLOR_BLACK);
     init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
+    auto now{std::chrono::steady_clock::now()};
+    if (now >= next_sample) {
+      werase(system_window);
+      box(system_window, 0, 0);
+      processes = &sample(system_window);
+      if (!filter.Empty()) processes->Filter(matches);
+      processes->Sort(sort, Descending(sort));
+      next_sample = now + interval;
+    }
+
+    werase(process_window);
     box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
+    DisplayProcesses(*processes, process_window, n, sort);
+    DisplayFilter(query, editing, filter, processes->Order().size(),
+                  process_window);
     wrefresh(system_window);
     wrefresh(process_window);
     refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    auto wait{std::chrono::duration_cast<std::chrono::milliseconds>(
+        next_sample - std::chrono::steady_clock::now())};
+    timeout(std::max(0, static_cast<int>(wait.count())));
+    int key = getch();
+    if (key == ERR) continue;
+    if (!editing && SelectSort(key, sort)) {
+      processes->Sort(sort, Descending(sort));
+      continue;
+    }
+    if (!EditQuery(key, query, editing)) continue;
+
+    ProcessFilter next(query);
+    bool const incremental{next.Refines(filter)};
+    filter = std::move(next);
+    if (incremental) {
+      processes->Refine(matches);
+    } else {
+      processes->Filter(matches);
+      processes->Sort(sort, Descending(sort));
+    }
   }
   endwin();
-}
\ No newline at end of file
+}
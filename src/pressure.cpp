@@ -0,0 +1,33 @@
+#include <chrono>
+#include <string>
+#include <utility>
+
+#include "linux_parser.h"
+#include "pressure.h"
+
+using std::string;
+
+Pressure::Pressure(string resource) : resource_(std::move(resource)) {}
+
+// DONE: Return the share of the last interval spent stalled
+float Pressure::Stall() {
+  long total;
+  if (!LinuxParser::PressureTotal(resource_, total)) return -1;
+  auto now = std::chrono::steady_clock::now();
+
+  float stall = 0;
+  if (prev_total_ >= 0) {
+    long delta_total = total - prev_total_;
+    long delta_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                          now - prev_time_)
+                          .count();
+    // Prevent divide by 0
+    if (delta_time > 0) stall = (float)delta_total / (float)delta_time;
+    if (stall > 1) stall = 1;
+  }
+
+  // Update private previous values
+  prev_total_ = total;
+  prev_time_ = now;
+  return stall;
+}
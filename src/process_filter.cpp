@@ -0,0 +1,128 @@
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "process_filter.h"
+#include "process_table.h"
+
+using std::size_t;
+using std::string;
+
+namespace {
+// Only digits and a single '.', so that appending characters never lowers
+// the value (see ProcessFilter::Refines)
+bool ParsePercent(const string& text, float& percent) {
+  int dots{0};
+  for (char c : text) {
+    if (c == '.') {
+      if (++dots > 1) return false;
+    } else if (!isdigit(static_cast<unsigned char>(c))) {
+      return false;
+    }
+  }
+  // strtof, unlike stof, does not throw on very long numbers
+  percent = std::strtof(text.c_str(), nullptr);
+  return true;
+}
+
+bool HasPrefix(const string& text, const string& prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+}  // namespace
+
+ProcessFilter::ProcessFilter(const string& query) {
+  std::istringstream stream(query);
+  string word;
+  while (stream >> word) {
+    Term term;
+    if (HasPrefix(word, "user:")) {
+      term.kind = Kind::kUser;
+      term.text = word.substr(5);
+    } else if (HasPrefix(word, "host:")) {
+      term.kind = Kind::kHost;
+      term.text = word.substr(5);
+    } else if (HasPrefix(word, "state:")) {
+      term.kind = Kind::kState;
+      term.text = word.substr(6);
+    } else if (HasPrefix(word, "cpu:")) {
+      term.kind = Kind::kCpu;
+      term.text = word.substr(4);
+      if (!ParsePercent(term.text, term.min_cpu)) valid_ = false;
+    } else if (HasPrefix(word, "re:")) {
+      term.kind = Kind::kRegex;
+      term.text = word.substr(3);
+      try {
+        term.regex = std::regex(term.text, std::regex::optimize);
+      } catch (const std::regex_error&) {
+        // Usually a pattern that is still being typed; match everything
+        valid_ = false;
+        term.text.clear();
+      }
+    } else {
+      term.kind = Kind::kCommand;
+      term.text = word;
+    }
+    terms_.push_back(std::move(term));
+  }
+}
+
+// State and CPU terms only read columns filled by the cheap pass, so they
+// run first and spare the user and command fetches for rows they reject
+bool ProcessFilter::Matches(ProcessTable& table, size_t row) const {
+  for (const Term& term : terms_) {
+    bool cheap = term.kind == Kind::kState || term.kind == Kind::kCpu;
+    if (cheap && !MatchesTerm(term, table, row)) return false;
+  }
+  for (const Term& term : terms_) {
+    bool cheap = term.kind == Kind::kState || term.kind == Kind::kCpu;
+    if (!cheap && !MatchesTerm(term, table, row)) return false;
+  }
+  return true;
+}
+
+bool ProcessFilter::MatchesTerm(const Term& term, ProcessTable& table,
+                                size_t row) {
+  switch (term.kind) {
+    case Kind::kCommand:
+      return table.Command(row).find(term.text) != string::npos;
+    case Kind::kUser:
+      return table.User(row).find(term.text) != string::npos;
+    case Kind::kHost:
+      return table.Host(row).find(term.text) != string::npos;
+    case Kind::kState:
+      return term.text.empty() ||
+             term.text.find(table.State(row)) != string::npos;
+    case Kind::kCpu:
+      return table.CpuUtilization(row) * 100 >= term.min_cpu;
+    case Kind::kRegex:
+      return term.text.empty() ||
+             std::regex_search(table.Command(row), term.regex);
+  }
+  return true;
+}
+
+// Holds when the query only grew: earlier terms are unchanged and the last
+// previous term was extended in a way that can only narrow it. Extending a
+// state or regex term can widen it ("state:R" -> "state:RS", "re:a" ->
+// "re:a|b"), so those force a full pass.
+bool ProcessFilter::Refines(const ProcessFilter& previous) const {
+  if (!valid_ || !previous.valid_) return false;
+  if (terms_.size() < previous.terms_.size()) return false;
+  for (size_t i = 0; i < previous.terms_.size(); ++i) {
+    const Term& before = previous.terms_[i];
+    const Term& after = terms_[i];
+    if (after.kind != before.kind) return false;
+    if (after.text == before.text) continue;
+    bool last = (i + 1 == previous.terms_.size());
+    bool narrowing = after.kind == Kind::kCommand ||
+                     after.kind == Kind::kUser || after.kind == Kind::kHost ||
+                     after.kind == Kind::kCpu;
+    if (!last || !narrowing || !HasPrefix(after.text, before.text))
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process_table.h"
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+// With carry, keeps the fetched details so that the next tick does not read
+// them again
+void ProcessTable::Clear(bool carry) {
+  carried_.clear();
+  for (size_t row = 0; carry && row < pid_.size(); ++row) {
+    if (fetched_[row] == 0) continue;
+    carried_[pid_[row]] = {start_time_[row], std::move(comm_[row]),
+                           fetched_[row],    wait_ns_[row],
+                           wait_time_[row],  uid_[row],
+                           std::move(user_[row]), std::move(command_[row])};
+  }
+
+  pid_.clear();
+  cpu_.clear();
+  wait_.clear();
+  wait_ns_.clear();
+  wait_time_.clear();
+  ram_.clear();
+  up_time_.clear();
+  state_.clear();
+  start_time_.clear();
+  comm_.clear();
+  fetched_.clear();
+  uid_.clear();
+  user_.clear();
+  command_.clear();
+  host_.clear();
+  order_.clear();
+  hosts_.clear();
+  counters_ = {};
+}
+
+void ProcessTable::Reserve(size_t rows) {
+  pid_.reserve(rows);
+  cpu_.reserve(rows);
+  wait_.reserve(rows);
+  wait_ns_.reserve(rows);
+  wait_time_.reserve(rows);
+  ram_.reserve(rows);
+  up_time_.reserve(rows);
+  state_.reserve(rows);
+  start_time_.reserve(rows);
+  comm_.reserve(rows);
+  fetched_.reserve(rows);
+  uid_.reserve(rows);
+  user_.reserve(rows);
+  command_.reserve(rows);
+  host_.reserve(rows);
+  order_.reserve(rows);
+}
+
+void ProcessTable::Append(int pid, float cpu, long ram, long up_time,
+                          char state, long start_time, const char* comm) {
+  order_.push_back(pid_.size());
+  pid_.push_back(pid);
+  cpu_.push_back(cpu);
+  wait_.push_back(0);
+  ram_.push_back(ram);
+  up_time_.push_back(up_time);
+  state_.push_back(state);
+  start_time_.push_back(start_time);
+  comm_.emplace_back(comm);
+  host_.push_back(-1);
+
+  // A matching start time rules out a reused PID, a matching comm an exec
+  auto carried = carried_.find(pid);
+  if (carried != carried_.end() && carried->second.start_time == start_time &&
+      carried->second.comm == comm_.back()) {
+    // The wait is re-read every tick, against the carried sample
+    unsigned char fetched = carried->second.fetched & ~kWait_;
+    if (fetched & kDetails_) fetched |= kCarried_;
+    fetched_.push_back(fetched);
+    wait_ns_.push_back(carried->second.wait_ns);
+    wait_time_.push_back(carried->second.wait_time);
+    uid_.push_back(carried->second.uid);
+    user_.push_back(std::move(carried->second.user));
+    command_.push_back(std::move(carried->second.command));
+  } else {
+    fetched_.push_back(0);
+    wait_ns_.push_back(0);
+    wait_time_.emplace_back();
+    uid_.push_back(-1);
+    user_.emplace_back();
+    command_.emplace_back();
+  }
+}
+
+// Share of the time since this process was last sampled; a process seen
+// for the first time reports 0
+float ProcessTable::RunQueueWait(size_t row) {
+  if (!(fetched_[row] & kWait_)) {
+    ++counters_.schedstat;
+    long wait_ns;
+    auto const now = Clock::now();
+    wait_[row] = 0;
+    if (LinuxParser::RunQueueWait(pid_[row], wait_ns)) {
+      long const interval =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              now - wait_time_[row])
+              .count();
+      bool const sampled = wait_time_[row] != Clock::time_point();
+      if (sampled && interval > 0 && wait_ns >= wait_ns_[row])
+        wait_[row] = (float)(wait_ns - wait_ns_[row]) / (float)interval;
+      wait_ns_[row] = wait_ns;
+      wait_time_[row] = now;
+    }
+    fetched_[row] |= kWait_;
+  }
+  return wait_[row];
+}
+
+void ProcessTable::SetRunQueueWait(size_t row, float wait) {
+  wait_[row] = wait;
+  fetched_[row] |= kWait_;
+}
+
+int ProcessTable::Uid(size_t row) {
+  if (!(fetched_[row] & kUid_)) {
+    ++counters_.status;
+    string uid = LinuxParser::Uid(pid_[row]);
+    uid_[row] = uid.empty() ? -1 : std::atoi(uid.c_str());
+    fetched_[row] |= kUid_;
+  }
+  return uid_[row];
+}
+
+const string& ProcessTable::User(size_t row) {
+  if (!(fetched_[row] & kUser_)) {
+    int uid = Uid(row);
+    auto name = user_names_.find(uid);
+    if (name == user_names_.end()) {
+      ++counters_.passwd;
+      name = user_names_.emplace(uid, LinuxParser::UserName(uid)).first;
+    }
+    user_[row] = name->second;
+    fetched_[row] |= kUser_;
+  }
+  return user_[row];
+}
+
+void ProcessTable::Revalidate(size_t row) {
+  if (fetched_[row] & kCarried_)
+    fetched_[row] &= ~(kDetails_ | kCarried_);
+}
+
+bool ProcessTable::DetailsCarried(size_t row) const {
+  return (fetched_[row] & kCarried_) &&
+         (fetched_[row] & kDetails_) == kDetails_;
+}
+
+const string& ProcessTable::Command(size_t row) {
+  if (!(fetched_[row] & kCommand_)) {
+    ++counters_.cmdline;
+    command_[row] = LinuxParser::Command(pid_[row]);
+    fetched_[row] |= kCommand_;
+  }
+  return command_[row];
+}
+
+void ProcessTable::SetDetails(size_t row, int uid, string user,
+                              string command) {
+  uid_[row] = uid;
+  user_[row] = std::move(user);
+  command_[row] = std::move(command);
+  fetched_[row] |= kUid_ | kUser_ | kCommand_;
+}
+
+int ProcessTable::AddHost(string name) {
+  hosts_.push_back(std::move(name));
+  return hosts_.size() - 1;
+}
+
+const string& ProcessTable::Host(size_t row) const {
+  static const string local;
+  return host_[row] < 0 ? local : hosts_[host_[row]];
+}
+
+void ProcessTable::Filter(const std::function<bool(size_t)>& keep) {
+  order_.clear();
+  for (size_t row = 0; row < pid_.size(); ++row) {
+    if (keep(row)) order_.push_back(row);
+  }
+}
+
+void ProcessTable::Refine(const std::function<bool(size_t)>& keep) {
+  order_.erase(std::remove_if(order_.begin(), order_.end(),
+                              [&](size_t row) { return !keep(row); }),
+               order_.end());
+}
+
+// Only the key column and the PID column are touched while sorting
+template <typename T>
+void ProcessTable::SortBy(const vector<T>& column, bool descending) {
+  const vector<int>& pid = pid_;
+  std::sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+    if (column[a] != column[b])
+      return descending ? column[b] < column[a] : column[a] < column[b];
+    return pid[a] < pid[b];
+  });
+}
+
+void ProcessTable::Sort(Column column, bool descending) {
+  switch (column) {
+    case Column::kPid:
+      SortBy(pid_, descending);
+      break;
+    case Column::kCpu:
+      SortBy(cpu_, descending);
+      break;
+    case Column::kWait:
+      for (size_t row : order_) RunQueueWait(row);
+      SortBy(wait_, descending);
+      break;
+    case Column::kRam:
+      SortBy(ram_, descending);
+      break;
+    case Column::kUpTime:
+      SortBy(up_time_, descending);
+      break;
+    case Column::kState:
+      SortBy(state_, descending);
+      break;
+    case Column::kUid:
+      for (size_t row : order_) Uid(row);
+      SortBy(uid_, descending);
+      break;
+  }
+}
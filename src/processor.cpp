@@ -1,29 +1,28 @@
 #include "processor.h"
 #include <iostream>
-#include <string>
-#include <vector>
 #include "linux_parser.h"
 
-using std::stol;
-using std::vector;
-
 // DONE: Return the aggregate CPU utilization
 float Processor::Utilization() {
-  vector<std::string> cpu_vals = LinuxParser::CpuUtilization();
+  LinuxParser::CpuTimes times;
   long total_time, delta_total_time;
   long busy_time, delta_busy_time;
   float utilization = 0;
 
-  user_time = stol(cpu_vals[0]);
-  nice_time = stol(cpu_vals[1]);
-  system_time = stol(cpu_vals[2]);
-  idle_time = stol(cpu_vals[3]);
-  iowait_time = stol(cpu_vals[4]);
-  irq_time = stol(cpu_vals[5]);
-  softirq_time = stol(cpu_vals[6]);
-  steal_time = stol(cpu_vals[7]);
-  guest_time = stol(cpu_vals[8]);
-  guest_nice_time = stol(cpu_vals[9]);
+  // Keep the previous sample if /proc/stat cannot be parsed; the next good
+  // read then covers both intervals
+  if (!LinuxParser::SystemCpuTimes(times)) return prev_utilization;
+
+  user_time = times.user;
+  nice_time = times.nice;
+  system_time = times.system;
+  idle_time = times.idle;
+  iowait_time = times.iowait;
+  irq_time = times.irq;
+  softirq_time = times.softirq;
+  steal_time = times.steal;
+  guest_time = times.guest;
+  guest_nice_time = times.guest_nice;
 
   // std::cout << user_time << "\t" << idle_time << "\n";
 
@@ -48,5 +47,6 @@ float Processor::Utilization() {
   if (delta_total_time != 0)
     utilization = (double)delta_busy_time / (double)delta_total_time;
 
+  this->prev_utilization = utilization;
   return utilization;
 }
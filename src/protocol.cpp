@@ -0,0 +1,245 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "process_table.h"
+#include "protocol.h"
+
+using std::int32_t;
+using std::int64_t;
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::uint64_t;
+
+namespace {
+// Row carries uid, user and command
+const unsigned char kHasDetails{1};
+
+void PutU8(string& out, unsigned char value) { out += (char)value; }
+
+void PutU32(string& out, uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) out += (char)(value >> shift);
+}
+
+void PutU64(string& out, uint64_t value) {
+  for (int shift = 0; shift < 64; shift += 8) out += (char)(value >> shift);
+}
+
+void PutString(string& out, const string& value) {
+  size_t size = value.size() < 0xffff ? value.size() : 0xffff;
+  out += (char)size;
+  out += (char)(size >> 8);
+  out.append(value, 0, size);
+}
+
+void SetU32(string& out, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; ++i) out[offset + i] = (char)(value >> (8 * i));
+}
+
+// Bounds-checked reads; any overrun clears ok and yields zeros
+struct Reader {
+  const unsigned char* data;
+  size_t size;
+  size_t position{0};
+  bool ok{true};
+
+  bool Has(size_t bytes) {
+    if (!ok || size - position < bytes) ok = false;
+    return ok;
+  }
+  unsigned char U8() { return Has(1) ? data[position++] : 0; }
+  uint32_t U32() {
+    if (!Has(4)) return 0;
+    uint32_t value{0};
+    for (int i = 0; i < 4; ++i) value |= (uint32_t)data[position++] << (8 * i);
+    return value;
+  }
+  uint64_t U64() {
+    if (!Has(8)) return 0;
+    uint64_t value{0};
+    for (int i = 0; i < 8; ++i) value |= (uint64_t)data[position++] << (8 * i);
+    return value;
+  }
+  string String() {
+    size_t length = U8();
+    length |= (size_t)U8() << 8;
+    if (!Has(length)) return string();
+    string value((const char*)data + position, length);
+    position += length;
+    return value;
+  }
+};
+
+void PutSummary(string& out, const Protocol::Summary& summary) {
+  PutString(out, summary.host);
+  PutString(out, summary.os);
+  PutString(out, summary.kernel);
+  PutU32(out, summary.cpu);
+  PutU32(out, summary.memory);
+  for (uint32_t load : summary.load) PutU32(out, load);
+  for (int32_t pressure : summary.pressure) PutU32(out, pressure);
+  PutU32(out, summary.total_processes);
+  PutU32(out, summary.running_processes);
+  PutU64(out, summary.up_time);
+  PutU32(out, summary.clock_ticks);
+}
+
+void GetSummary(Reader& in, Protocol::Summary& summary) {
+  summary.host = in.String();
+  summary.os = in.String();
+  summary.kernel = in.String();
+  summary.cpu = in.U32();
+  summary.memory = in.U32();
+  for (uint32_t& load : summary.load) load = in.U32();
+  for (int32_t& pressure : summary.pressure) pressure = (int32_t)in.U32();
+  summary.total_processes = (int32_t)in.U32();
+  summary.running_processes = (int32_t)in.U32();
+  summary.up_time = (int64_t)in.U64();
+  summary.clock_ticks = (int32_t)in.U32();
+}
+
+bool SameValues(const Protocol::Row& a, const Protocol::Row& b) {
+  return a.cpu == b.cpu && a.wait == b.wait && a.ram == b.ram &&
+         a.state == b.state;
+}
+}  // namespace
+
+uint32_t Protocol::Fraction(float value) {
+  if (!(value > 0)) return 0;
+  float scaled = value * kFractionScale + 0.5f;
+  return scaled < 4e9f ? (uint32_t)scaled : 4000000000u;
+}
+
+// Rows unchanged at the protocol's fixed-point resolution are skipped, so
+// idle processes cost nothing after the first frame. Details are sent with
+// a row the peer has not seen, and again whenever the table re-read them
+// and they differ from what was sent.
+string Protocol::Encoder::Frame(const Summary& summary,
+                                ProcessTable& processes) {
+  string frame;
+  PutU32(frame, 0);  // payload size, patched below
+  PutSummary(frame, summary);
+
+  size_t const count_offset{frame.size()};
+  PutU32(frame, 0);
+  uint32_t changed{0};
+  std::unordered_map<int32_t, Row> sent;
+  sent.reserve(processes.Size());
+  for (size_t row = 0; row < processes.Size(); ++row) {
+    Row current;
+    current.pid = processes.Pid(row);
+    current.start_time = processes.StartTime(row);
+    current.cpu = Fraction(processes.CpuUtilization(row));
+    current.wait = Fraction(processes.RunQueueWait(row));
+    current.ram = processes.Ram(row);
+    current.state = processes.State(row);
+
+    auto previous = sent_.find(current.pid);
+    bool const fresh = previous == sent_.end() ||
+                       previous->second.start_time != current.start_time;
+    bool details{fresh};
+    if (!fresh && processes.DetailsCarried(row)) {
+      // Unchanged since they were sent; moved rather than copied
+      current.uid = previous->second.uid;
+      current.user = std::move(previous->second.user);
+      current.command = std::move(previous->second.command);
+    } else {
+      current.uid = processes.Uid(row);
+      current.user = processes.User(row);
+      current.command = processes.Command(row);
+      details = fresh || current.uid != previous->second.uid ||
+                current.user != previous->second.user ||
+                current.command != previous->second.command;
+    }
+
+    if (details || !SameValues(previous->second, current)) {
+      ++changed;
+      PutU32(frame, current.pid);
+      PutU8(frame, details ? kHasDetails : 0);
+      PutU64(frame, current.start_time);
+      PutU32(frame, current.cpu);
+      PutU32(frame, current.wait);
+      PutU64(frame, current.ram);
+      PutU8(frame, current.state);
+      if (details) {
+        PutU32(frame, current.uid);
+        PutString(frame, current.user);
+        PutString(frame, current.command);
+      }
+    }
+    sent.emplace(current.pid, std::move(current));
+  }
+  SetU32(frame, count_offset, changed);
+
+  size_t const removed_offset{frame.size()};
+  PutU32(frame, 0);
+  uint32_t removed{0};
+  for (auto const& previous : sent_) {
+    if (sent.count(previous.first)) continue;
+    ++removed;
+    PutU32(frame, previous.first);
+  }
+  SetU32(frame, removed_offset, removed);
+
+  sent_ = std::move(sent);
+  SetU32(frame, 0, frame.size() - 4);
+  return frame;
+}
+
+bool Protocol::Decoder::Feed(const char* data, size_t size) {
+  pending_.append(data, size);
+  size_t offset{0};
+  while (pending_.size() - offset >= 4) {
+    Reader header{(const unsigned char*)pending_.data() + offset, 4};
+    uint32_t const payload{header.U32()};
+    if (payload > kMaxFrameSize) return false;
+    if (pending_.size() - offset - 4 < payload) break;
+    if (!Apply(pending_.data() + offset + 4, payload)) return false;
+    offset += 4 + payload;
+  }
+  pending_.erase(0, offset);
+  return true;
+}
+
+void Protocol::Decoder::Reset() {
+  pending_.clear();
+  ready_ = false;
+  summary_ = {};
+  rows_.clear();
+  changed_ = 0;
+}
+
+bool Protocol::Decoder::Apply(const char* payload, size_t size) {
+  Reader in{(const unsigned char*)payload, size};
+  GetSummary(in, summary_);
+
+  uint32_t changed{in.U32()};
+  changed_ = 0;
+  while (in.ok && changed-- > 0) {
+    int32_t pid = (int32_t)in.U32();
+    unsigned char flags = in.U8();
+    Row& row = rows_[pid];
+    row.pid = pid;
+    row.start_time = (int64_t)in.U64();
+    row.cpu = in.U32();
+    row.wait = in.U32();
+    row.ram = (int64_t)in.U64();
+    row.state = (char)in.U8();
+    if (flags & kHasDetails) {
+      row.uid = (int32_t)in.U32();
+      row.user = in.String();
+      row.command = in.String();
+    }
+    if (in.ok) ++changed_;
+  }
+
+  uint32_t removed{in.U32()};
+  while (in.ok && removed-- > 0) rows_.erase((int32_t)in.U32());
+
+  ready_ = in.ok;
+  return in.ok && in.position == size;
+}
@@ -0,0 +1,387 @@
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process_table.h"
+#include "protocol.h"
+#include "remote.h"
+#include "system.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+const string kUnixPrefix{"unix:"};
+
+bool IsUnix(const string& endpoint) {
+  return endpoint.compare(0, kUnixPrefix.size(), kUnixPrefix) == 0;
+}
+
+bool UnixAddress(const string& endpoint, sockaddr_un& address) {
+  string const path{endpoint.substr(kUnixPrefix.size())};
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  memcpy(address.sun_path, path.c_str(), path.size());
+  return true;
+}
+
+// A socket file left behind by an agent that is no longer running
+bool StaleSocket(const sockaddr_un& address) {
+  struct stat info;
+  if (lstat(address.sun_path, &info) < 0 || !S_ISSOCK(info.st_mode))
+    return false;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+  bool const refused = connect(fd, (sockaddr*)&address, sizeof(address)) < 0 &&
+                       errno == ECONNREFUSED;
+  close(fd);
+  return refused;
+}
+
+// host:port, [v6-host]:port or :port. The stream is unauthenticated and
+// carries every command line, so an empty host stays on loopback; listening
+// on every interface takes an explicit 0.0.0.0 or [::].
+addrinfo* TcpAddresses(const string& endpoint, bool passive) {
+  size_t const colon{endpoint.rfind(':')};
+  if (colon == string::npos) return nullptr;
+  string host{endpoint.substr(0, colon)};
+  string const port{endpoint.substr(colon + 1)};
+  if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+    host = host.substr(1, host.size() - 2);
+
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  char const* node{host.empty() ? (passive ? "127.0.0.1" : "localhost")
+                                : host.c_str()};
+  addrinfo* addresses{nullptr};
+  if (getaddrinfo(node, port.c_str(), &hints, &addresses) != 0)
+    return nullptr;
+  return addresses;
+}
+
+// A client that has not taken this much of its backlog when the next frame
+// is due is dropped, so one stalled console cannot hold the agent up
+constexpr size_t kMaxBacklog{16 << 20};
+
+void SetNonBlocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Send as much of pending as the socket takes now; false if the peer is gone
+bool Flush(int fd, string& pending) {
+  size_t sent{0};
+  while (sent < pending.size()) {
+    ssize_t n =
+        send(fd, pending.data() + sent, pending.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n <= 0) return false;
+    sent += n;
+  }
+  pending.erase(0, sent);
+  return true;
+}
+
+Protocol::Summary Summarize(System& system, const string& host) {
+  Protocol::Summary summary;
+  summary.host = host;
+  summary.os = system.OperatingSystem();
+  summary.kernel = system.Kernel();
+  summary.cpu = Protocol::Fraction(system.Cpu().Utilization());
+  summary.memory = Protocol::Fraction(system.MemoryUtilization());
+  LinuxParser::LoadAvg load{system.LoadAverage()};
+  summary.load[0] = Protocol::Fraction(load.one);
+  summary.load[1] = Protocol::Fraction(load.five);
+  summary.load[2] = Protocol::Fraction(load.fifteen);
+  Pressure* pressures[]{&system.CpuPressure(), &system.MemoryPressure(),
+                        &system.IoPressure()};
+  for (int i = 0; i < 3; ++i) {
+    float stall{pressures[i]->Stall()};
+    summary.pressure[i] = stall < 0 ? -1 : Protocol::Fraction(stall);
+  }
+  summary.total_processes = system.TotalProcesses();
+  summary.running_processes = system.RunningProcesses();
+  summary.up_time = system.UpTime();
+  summary.clock_ticks = sysconf(_SC_CLK_TCK);
+  return summary;
+}
+}  // namespace
+
+int Remote::Listen(const string& endpoint) {
+  if (IsUnix(endpoint)) {
+    sockaddr_un address;
+    if (!UnixAddress(endpoint, address)) return -1;
+    // Never remove a file that is not a socket, or one an agent answers on
+    struct stat info;
+    if (lstat(address.sun_path, &info) == 0) {
+      if (!StaleSocket(address)) {
+        errno = EADDRINUSE;
+        return -1;
+      }
+      unlink(address.sun_path);
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(fd, 16) < 0) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  addrinfo* addresses{TcpAddresses(endpoint, true)};
+  int fd{-1};
+  for (addrinfo* a = addresses; a != nullptr && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) continue;
+    int const reuse{1};
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, a->ai_addr, a->ai_addrlen) < 0 || listen(fd, 16) < 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  if (addresses != nullptr) freeaddrinfo(addresses);
+  return fd;
+}
+
+vector<Remote::Address> Remote::Resolve(const string& endpoint) {
+  vector<Address> resolved;
+  Address address;
+  memset(&address, 0, sizeof(address));
+  if (IsUnix(endpoint)) {
+    sockaddr_un unix_address;
+    if (!UnixAddress(endpoint, unix_address)) return resolved;
+    memcpy(&address.storage, &unix_address, sizeof(unix_address));
+    address.length = sizeof(unix_address);
+    resolved.push_back(address);
+    return resolved;
+  }
+
+  addrinfo* addresses{TcpAddresses(endpoint, false)};
+  for (addrinfo* a = addresses; a != nullptr; a = a->ai_next) {
+    if (a->ai_addrlen > sizeof(address.storage)) continue;
+    memcpy(&address.storage, a->ai_addr, a->ai_addrlen);
+    address.length = a->ai_addrlen;
+    resolved.push_back(address);
+  }
+  if (addresses != nullptr) freeaddrinfo(addresses);
+  return resolved;
+}
+
+int Remote::Connect(const Address& address) {
+  int fd = socket(address.storage.ss_family, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  SetNonBlocking(fd);
+  // A unix socket with a full backlog reports EAGAIN rather than waiting
+  if (connect(fd, (const sockaddr*)&address.storage, address.length) < 0 &&
+      errno != EINPROGRESS && errno != EAGAIN) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int Remote::Serve(System& system, const string& endpoint, const string& host) {
+  int listener = Listen(endpoint);
+  if (listener < 0) {
+    std::cerr << "monitor: cannot listen on " << endpoint << ": "
+              << strerror(errno) << "\n";
+    return 1;
+  }
+
+  struct Client {
+    int fd;
+    Protocol::Encoder encoder;
+    string pending;  // encoded but not yet taken by the socket
+  };
+  vector<Client> clients;
+  vector<pollfd> polls;
+  auto const interval{std::chrono::seconds(1)};
+  auto next_sample{std::chrono::steady_clock::now()};
+
+  while (1) {
+    auto now{std::chrono::steady_clock::now()};
+    if (now >= next_sample) {
+      // Sample even with no clients so CPU and pressure deltas stay current
+      Protocol::Summary summary{Summarize(system, host)};
+      ProcessTable& processes{system.Processes()};
+      for (Client& client : clients) {
+        if (client.pending.size() > kMaxBacklog) {
+          close(client.fd);
+          client.fd = -1;
+          continue;
+        }
+        client.pending += client.encoder.Frame(summary, processes);
+        if (Flush(client.fd, client.pending)) continue;
+        close(client.fd);
+        client.fd = -1;
+      }
+      next_sample = now + interval;
+    }
+
+    // Until the next sample is due: accept new clients, drain backlogs and
+    // notice clients that hung up
+    polls.assign(1, {listener, POLLIN, 0});
+    for (Client& client : clients)
+      polls.push_back(
+          {client.fd, (short)(client.pending.empty() ? 0 : POLLOUT), 0});
+    auto wait{std::chrono::duration_cast<std::chrono::milliseconds>(
+        next_sample - std::chrono::steady_clock::now())};
+    if (poll(polls.data(), polls.size(), std::max(0, (int)wait.count())) > 0) {
+      for (size_t i = 0; i < clients.size(); ++i) {
+        short const events{polls[i + 1].revents};
+        bool gone = (events & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+        if (!gone && (events & POLLOUT))
+          gone = !Flush(clients[i].fd, clients[i].pending);
+        if (!gone) continue;
+        close(clients[i].fd);
+        clients[i].fd = -1;
+      }
+      if (polls[0].revents & POLLIN) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd >= 0) {
+          SetNonBlocking(fd);
+          clients.push_back({fd, Protocol::Encoder(), string()});
+        }
+      }
+    }
+    clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                 [](const Client& c) { return c.fd < 0; }),
+                  clients.end());
+  }
+  close(listener);
+  return 0;
+}
+
+Remote::Source::Source(string endpoint) : endpoint_(std::move(endpoint)) {}
+
+Remote::Source::Source(Source&& other)
+    : endpoint_(std::move(other.endpoint_)),
+      fd_(other.fd_),
+      connecting_(other.connecting_),
+      addresses_(std::move(other.addresses_)),
+      next_address_(other.next_address_),
+      deadline_(other.deadline_),
+      backoff_(other.backoff_),
+      decoder_(std::move(other.decoder_)) {
+  other.fd_ = -1;
+}
+
+Remote::Source::~Source() { Disconnect(); }
+
+void Remote::Source::Disconnect() {
+  if (fd_ >= 0) close(fd_);
+  fd_ = -1;
+  connecting_ = false;
+}
+
+// Start connecting to the next address the endpoint resolved to; false once
+// every address has been tried
+bool Remote::Source::ConnectNext() {
+  Disconnect();
+  while (next_address_ < addresses_.size()) {
+    fd_ = Connect(addresses_[next_address_++]);
+    if (fd_ < 0) continue;
+    connecting_ = true;
+    deadline_ = Clock::now() + kConnectTimeout;
+    return true;
+  }
+  return false;
+}
+
+// Drop the connection and wait before resolving the endpoint again, twice
+// as long each time none of its addresses can be reached
+void Remote::Source::Retry() {
+  Disconnect();
+  addresses_.clear();
+  next_address_ = 0;
+  deadline_ = Clock::now() + backoff_;
+  backoff_ = std::min(backoff_ * 2, kMaxBackoff);
+}
+
+void Remote::Source::Poll() {
+  if (fd_ < 0) {
+    if (Clock::now() < deadline_) return;
+    addresses_ = Resolve(endpoint_);
+    next_address_ = 0;
+    if (!ConnectNext()) {
+      Retry();
+      return;
+    }
+  }
+
+  // A refused or timed out address moves on to the next one, e.g. from ::1
+  // to 127.0.0.1 for localhost
+  while (connecting_) {
+    pollfd writable{fd_, POLLOUT, 0};
+    int error{0};
+    socklen_t length{sizeof(error)};
+    if (poll(&writable, 1, 0) == 0) {
+      if (Clock::now() < deadline_) return;
+    } else if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length) == 0 &&
+               error == 0) {
+      connecting_ = false;
+      backoff_ = kMinBackoff;
+      // A new connection starts again from a full snapshot
+      decoder_.Reset();
+      break;
+    }
+    if (!ConnectNext()) {
+      Retry();
+      return;
+    }
+  }
+
+  char buffer[1 << 16];
+  while (1) {
+    ssize_t n = recv(fd_, buffer, sizeof(buffer), 0);
+    if (n > 0) {
+      if (!decoder_.Feed(buffer, n)) break;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    break;  // closed by the agent, or a malformed stream
+  }
+  Retry();
+}
+
+void Remote::Merge(vector<Source>& sources, ProcessTable& processes) {
+  processes.Clear(false);
+  for (Source& source : sources) {
+    const Protocol::Decoder& state{source.State()};
+    if (!source.Connected() || !state.Ready()) continue;
+    const Protocol::Summary& summary{state.System()};
+    int const host{processes.AddHost(summary.host)};
+    long const clock_ticks{summary.clock_ticks > 0 ? summary.clock_ticks : 100};
+    float const scale{(float)Protocol::kFractionScale};
+    for (auto const& entry : state.Rows()) {
+      const Protocol::Row& row{entry.second};
+      processes.Append(row.pid, row.cpu / scale, row.ram,
+                       summary.up_time - row.start_time / clock_ticks,
+                       row.state, row.start_time, "");
+      processes.SetRunQueueWait(processes.Size() - 1, row.wait / scale);
+      processes.SetDetails(processes.Size() - 1, row.uid, row.user,
+                           row.command);
+      processes.SetHost(processes.Size() - 1, host);
+    }
+  }
+}
@@ -6,7 +6,8 @@
 #include <vector>
 
 #include "linux_parser.h"
-#include "process.h"
+#include "pressure.h"
+#include "process_table.h"
 #include "processor.h"
 #include "system.h"
 
@@ -24,20 +25,30 @@ System::System() {
 Processor& System::Cpu() { return cpu_; }
 
 // DONE: Return a container composed of the system's processes
-vector<Process>& System::Processes() {
-  vector<int> new_pids{};
-
-  // To populate the vector with up-to-date PIDSs
-  // erase the old list
-  if (!processes_.empty()) processes_.clear();
-
-  // Up-to-date PIDs
-  new_pids = LinuxParser::Pids();
-
-  for (int new_pid : new_pids) {
-    processes_.push_back(Process(new_pid));
+// Rows are refreshed with a single /proc/PID/stat read per process; run
+// queue wait, user and command are left for the table to fetch for the rows
+// that need them
+ProcessTable& System::Processes() {
+  vector<int> pids = LinuxParser::Pids();
+  long const system_jiffies = LinuxParser::Jiffies();
+  long const system_up_time = LinuxParser::UpTime();
+  long const clock_ticks = sysconf(_SC_CLK_TCK);
+  long const page_kb = sysconf(_SC_PAGESIZE) / 1024;
+
+  processes_.Clear();
+  processes_.Reserve(pids.size());
+  for (int pid : pids) {
+    LinuxParser::ProcStat stat;
+    ++processes_.Collected().stat;
+    // The process may have exited since Pids() listed it
+    if (!LinuxParser::ProcessStat(pid, stat)) continue;
+
+    float cpu = 0;
+    if (system_jiffies > 0) cpu = (float)stat.active_jiffies / system_jiffies;
+    processes_.Append(pid, cpu, stat.rss * page_kb,
+                      system_up_time - stat.start_time / clock_ticks,
+                      stat.state, stat.start_time, stat.comm);
   }
-
   return (processes_);
 }
 
@@ -63,3 +74,15 @@ long int System::UpTime() {
 
   return up_time;
 }
+
+// DONE: Return the 1, 5 and 15 minute load averages
+LinuxParser::LoadAvg System::LoadAverage() {
+  LinuxParser::LoadAvg load;
+  LinuxParser::LoadAverage(load);
+  return load;
+}
+
+// DONE: Return the system's CPU, memory and IO pressure
+Pressure& System::CpuPressure() { return cpu_pressure_; }
+Pressure& System::MemoryPressure() { return memory_pressure_; }
+Pressure& System::IoPressure() { return io_pressure_; }
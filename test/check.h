@@ -0,0 +1,28 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+/*
+Assertions for the test executables. A failed CHECK prints its location and
+condition and the test carries on; main returns Check::Result().
+*/
+namespace Check {
+inline int failures{0};
+
+// Exit status of the test: 0 if every check held
+inline int Result() {
+  if (failures > 0) std::cerr << failures << " checks failed\n";
+  return failures > 0 ? 1 : 0;
+}
+};  // namespace Check
+
+#define CHECK(condition)                                               \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #condition "\n"; \
+      ++Check::failures;                                               \
+    }                                                                  \
+  } while (0)
+
+#endif
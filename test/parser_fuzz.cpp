@@ -0,0 +1,104 @@
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "linux_parser.h"
+
+/*
+One fuzz input run through every /proc parser. Built into parser_test, which
+feeds it truncated and mutated samples, and into the libFuzzer target when
+configured with -DMONITOR_FUZZ=ON (clang only).
+Aborts if a parser allocates or a successful parse breaks its contract.
+*/
+
+namespace {
+// Operator new calls while a parser runs
+bool counting{false};
+long allocations{0};
+
+// The size the readers in linux_parser.cpp use for a whole file
+const std::size_t kBufferSize{4096};
+
+void Require(bool condition, const char* parser, const char* what) {
+  if (condition) return;
+  std::fprintf(stderr, "%s: %s\n", parser, what);
+  std::abort();
+}
+}  // namespace
+
+void* operator new(std::size_t size) {
+  if (counting) ++allocations;
+  void* pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data,
+                                      std::size_t size) {
+  // Input as ReadFile would leave it: at most kBufferSize - 1 bytes and
+  // '\0' terminated
+  static char buffer[kBufferSize];
+  static char cmdline[kBufferSize];
+  if (size > kBufferSize - 1) size = kBufferSize - 1;
+  std::memcpy(buffer, data, size);
+  buffer[size] = '\0';
+  std::memcpy(cmdline, data, size);
+  cmdline[size] = '\0';
+
+  LinuxParser::CpuTimes times;
+  LinuxParser::ProcStat stat;
+  long total{-1}, free{-1}, uid{-1}, vm_size{-1};
+
+  allocations = 0;
+  counting = true;
+  bool const cpu = LinuxParser::ParseCpuTimes(buffer, times);
+  bool const proc = LinuxParser::ParseProcStat(buffer, stat);
+  LinuxParser::ParseMemInfo(buffer, total, free);
+  LinuxParser::ParseStatusField(buffer, "Uid:", uid);
+  LinuxParser::ParseStatusField(buffer, "VmSize:", vm_size);
+  std::size_t const length = LinuxParser::ParseCmdline(cmdline, size);
+  counting = false;
+  Require(allocations == 0, "parsers", "allocated");
+
+  if (cpu) {
+    long const fields[]{times.user,    times.nice,  times.system,
+                        times.idle,    times.iowait, times.irq,
+                        times.softirq, times.steal, times.guest,
+                        times.guest_nice};
+    for (long field : fields)
+      Require(field >= 0 && field <= LONG_MAX / 16, "ParseCpuTimes",
+              "field out of range");
+  }
+  if (proc) {
+    Require(std::memchr(stat.comm, '\0', sizeof(stat.comm)) != nullptr,
+            "ParseProcStat", "comm not terminated");
+    // Four fields of at most LONG_MAX / 16 each
+    Require(stat.active_jiffies <= LONG_MAX / 4 &&
+                stat.active_jiffies >= -LONG_MAX / 4,
+            "ParseProcStat", "active jiffies out of range");
+  } else {
+    LinuxParser::ProcStat const untouched;
+    Require(stat.comm[0] == '\0' && stat.state == untouched.state &&
+                stat.active_jiffies == untouched.active_jiffies &&
+                stat.start_time == untouched.start_time &&
+                stat.rss == untouched.rss,
+            "ParseProcStat", "wrote a result it rejected");
+  }
+  Require(length <= size, "ParseCmdline", "grew");
+  Require(cmdline[length] == '\0', "ParseCmdline", "not terminated");
+  Require(std::memchr(cmdline, '\0', length) == nullptr &&
+              std::memchr(cmdline, '\n', length) == nullptr,
+          "ParseCmdline", "left a separator");
+  Require(length == 0 || cmdline[length - 1] != ' ', "ParseCmdline",
+          "trailing space");
+  return 0;
+}
@@ -0,0 +1,165 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "linux_parser.h"
+
+/*
+Property test of the /proc parsers: known samples parse to known values,
+every truncation of them is rejected or still well formed, and random
+mutations neither crash nor allocate (see parser_fuzz.cpp).
+*/
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data,
+                                      std::size_t size);
+
+namespace {
+const std::string kCpuLine{
+    "cpu  10132153 290696 3084719 46828483 16683 0 25195 0 175628 0\n"
+    "cpu0 1393280 32966 572056 13343292 6130 0 17875 0 23933 0\n"};
+// comm with a space and a ')' of its own
+const std::string kProcStat{
+    "1234 (tmux: server) (x)) S 1 1234 1234 0 -1 4194560 1516 0 0 0 "
+    "120 35 4 6 20 0 1 0 5500 8859648 1099 18446744073709551615 1 1 0 0 0 "
+    "0 0 4096 134433283 0 0 0 17 2 0 0 0 0 0\n"};
+const std::string kMemInfo{
+    "MemTotal:       16301484 kB\nMemFree:         8002512 kB\n"
+    "MemAvailable:   12420604 kB\n"};
+const std::string kStatus{
+    "Name:\tbash\nState:\tS (sleeping)\nUid:\t1000\t1000\t1000\t1000\n"
+    "VmSize:\t   12268 kB\n"};
+const std::string kCmdline{std::string("/bin/sh\0-c\0echo hi\0", 19)};
+
+// Runs the fuzz entry point, which aborts on any violation
+void Fuzz(const std::string& input) {
+  LLVMFuzzerTestOneInput((const std::uint8_t*)input.data(), input.size());
+}
+
+void TestSamples() {
+  LinuxParser::CpuTimes times;
+  CHECK(LinuxParser::ParseCpuTimes(kCpuLine.c_str(), times));
+  CHECK(times.user == 10132153 && times.idle == 46828483);
+  CHECK(times.guest == 175628 && times.guest_nice == 0);
+
+  LinuxParser::ProcStat stat;
+  CHECK(LinuxParser::ParseProcStat(kProcStat.c_str(), stat));
+  CHECK(std::string(stat.comm) == "tmux: server) (x)");
+  CHECK(stat.state == 'S');
+  CHECK(stat.active_jiffies == 120 + 35 + 4 + 6);
+  CHECK(stat.start_time == 5500);
+  CHECK(stat.rss == 1099);
+
+  long total{0}, free{0};
+  CHECK(LinuxParser::ParseMemInfo(kMemInfo.c_str(), total, free));
+  CHECK(total == 16301484 && free == 8002512);
+
+  long value{0};
+  CHECK(LinuxParser::ParseStatusField(kStatus.c_str(), "Uid:", value));
+  CHECK(value == 1000);
+  CHECK(LinuxParser::ParseStatusField(kStatus.c_str(), "VmSize:", value));
+  CHECK(value == 12268);
+  CHECK(!LinuxParser::ParseStatusField(kStatus.c_str(), "VmRSS:", value));
+
+  std::string cmdline{kCmdline};
+  cmdline.push_back('\0');
+  std::size_t const length{
+      LinuxParser::ParseCmdline(&cmdline[0], kCmdline.size())};
+  CHECK(cmdline.substr(0, length) == "/bin/sh -c echo hi");
+}
+
+void TestMalformed() {
+  LinuxParser::CpuTimes times;
+  LinuxParser::ProcStat stat;
+  long value{0}, free{0};
+  // A sign without digits, with or without leading blanks
+  CHECK(!LinuxParser::ParseStatusField("Uid:\t-\n", "Uid:", value));
+  CHECK(!LinuxParser::ParseStatusField("Uid:-", "Uid:", value));
+  CHECK(!LinuxParser::ParseCpuTimes("cpu  1 - 2 3\n", times));
+  CHECK(!LinuxParser::ParseMemInfo("MemTotal: -\nMemFree: 1\n", value, free));
+  // Out of range, negative CPU times, and too few fields
+  CHECK(!LinuxParser::ParseStatusField("Uid: 99999999999999999999999", "Uid:",
+                                       value));
+  CHECK(!LinuxParser::ParseCpuTimes("cpu  1 2 -3 4\n", times));
+  CHECK(!LinuxParser::ParseCpuTimes("cpu  1 2 3\ncpu0 4 5 6 7\n", times));
+  // No parentheses around comm, or nothing after them
+  CHECK(!LinuxParser::ParseProcStat("1 (sh S 1 1 1", stat));
+  CHECK(!LinuxParser::ParseProcStat("1 (sh)", stat));
+  CHECK(!LinuxParser::ParseProcStat("1 (sh) ", stat));
+  CHECK(!LinuxParser::ParseProcStat("1 sh) S 1 1 1", stat));
+  // Numbers must not be read across a line break
+  CHECK(!LinuxParser::ParseStatusField("Uid:\n1000\n", "Uid:", value));
+}
+
+// Files read mid-update end early; parsers must reject the cut rather
+// than return the leading fields as if they were the whole record
+void TestTruncated() {
+  for (const std::string* sample :
+       {&kCpuLine, &kProcStat, &kMemInfo, &kStatus, &kCmdline})
+    for (std::size_t size = 0; size <= sample->size(); ++size)
+      Fuzz(sample->substr(0, size));
+
+  // Up to the first digit of rss, field (24), the record is incomplete
+  std::size_t const rss{kProcStat.find(" 1099 ") + 1};
+  LinuxParser::ProcStat stat;
+  for (std::size_t size = 0; size < rss; ++size)
+    CHECK(!LinuxParser::ParseProcStat(kProcStat.substr(0, size).c_str(), stat));
+
+  // user, nice, system and idle are required
+  std::size_t const idle{kCpuLine.find("46828483")};
+  LinuxParser::CpuTimes times;
+  for (std::size_t size = 0; size < idle; ++size)
+    CHECK(!LinuxParser::ParseCpuTimes(kCpuLine.substr(0, size).c_str(), times));
+
+  std::size_t const free_value{kMemInfo.find("8002512")};
+  long total, free;
+  for (std::size_t size = 0; size < free_value; ++size)
+    CHECK(!LinuxParser::ParseMemInfo(kMemInfo.substr(0, size).c_str(), total,
+                                     free));
+}
+
+// Byte flips, insertions of separators and digits, and deletions
+void TestMutated() {
+  std::mt19937 random(20240611);
+  const char interesting[]{' ', '\t', '\n', '\0', '-', '(', ')', '0', '9', ':'};
+  for (const std::string* sample :
+       {&kCpuLine, &kProcStat, &kMemInfo, &kStatus, &kCmdline}) {
+    for (int round = 0; round < 20000; ++round) {
+      std::string input{*sample};
+      int const edits = 1 + random() % 8;
+      for (int edit = 0; edit < edits && !input.empty(); ++edit) {
+        std::size_t const at = random() % input.size();
+        switch (random() % 4) {
+          case 0:
+            input[at] = (char)random();
+            break;
+          case 1:
+            input[at] = interesting[random() % sizeof(interesting)];
+            break;
+          case 2:
+            input.insert(at, 1, interesting[random() % sizeof(interesting)]);
+            break;
+          case 3:
+            input.erase(at, 1 + random() % 4);
+            break;
+        }
+      }
+      Fuzz(input);
+    }
+  }
+  // Longer than any reader's buffer
+  Fuzz(std::string(10000, '9'));
+  Fuzz("cpu " + std::string(10000, ' '));
+}
+}  // namespace
+
+int main() {
+  TestSamples();
+  TestMalformed();
+  TestTruncated();
+  TestMutated();
+  return Check::Result();
+}
@@ -0,0 +1,213 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "process_table.h"
+#include "protocol.h"
+
+/*
+Round trip of Protocol::Encoder frames through Protocol::Decoder: full and
+delta frames, frames split at every byte, and truncated payloads.
+*/
+
+namespace {
+struct Process {
+  int pid;
+  float cpu;
+  float wait;
+  long ram;
+  char state;
+  long start_time;
+  std::string user;
+  std::string command;
+};
+
+// Rows come with their details, so building the table reads nothing
+void Fill(ProcessTable& table, const std::vector<Process>& processes) {
+  table.Clear(false);
+  for (const Process& p : processes) {
+    table.Append(p.pid, p.cpu, p.ram, 0, p.state, p.start_time, "");
+    table.SetRunQueueWait(table.Size() - 1, p.wait);
+    table.SetDetails(table.Size() - 1, 1000 + p.pid, p.user, p.command);
+  }
+}
+
+Protocol::Summary MakeSummary() {
+  Protocol::Summary summary;
+  summary.host = "alpha";
+  summary.os = "Synthetic Linux";
+  summary.kernel = "6.1.0";
+  summary.cpu = Protocol::Fraction(0.25f);
+  summary.memory = Protocol::Fraction(0.5f);
+  summary.load[0] = Protocol::Fraction(1.5f);
+  summary.pressure[1] = Protocol::Fraction(0.01f);
+  summary.total_processes = 3;
+  summary.running_processes = 1;
+  summary.up_time = 12345;
+  summary.clock_ticks = 100;
+  return summary;
+}
+
+// The decoded state holds exactly the processes given
+void CheckRows(const Protocol::Decoder& decoder,
+               const std::vector<Process>& processes) {
+  CHECK(decoder.Rows().size() == processes.size());
+  for (const Process& p : processes) {
+    auto found = decoder.Rows().find(p.pid);
+    CHECK(found != decoder.Rows().end());
+    if (found == decoder.Rows().end()) continue;
+    const Protocol::Row& row = found->second;
+    CHECK(row.start_time == p.start_time);
+    CHECK(row.cpu == Protocol::Fraction(p.cpu));
+    CHECK(row.wait == Protocol::Fraction(p.wait));
+    CHECK(row.ram == p.ram);
+    CHECK(row.state == p.state);
+    CHECK(row.uid == 1000 + p.pid);
+    CHECK(row.user == p.user);
+    CHECK(row.command == p.command);
+  }
+}
+
+void CheckSummary(const Protocol::Summary& a, const Protocol::Summary& b) {
+  CHECK(a.host == b.host);
+  CHECK(a.os == b.os);
+  CHECK(a.kernel == b.kernel);
+  CHECK(a.cpu == b.cpu);
+  CHECK(a.memory == b.memory);
+  for (int i = 0; i < 3; ++i) {
+    CHECK(a.load[i] == b.load[i]);
+    CHECK(a.pressure[i] == b.pressure[i]);
+  }
+  CHECK(a.total_processes == b.total_processes);
+  CHECK(a.running_processes == b.running_processes);
+  CHECK(a.up_time == b.up_time);
+  CHECK(a.clock_ticks == b.clock_ticks);
+}
+
+void TestDeltas() {
+  std::vector<Process> processes{
+      {1, 0.01f, 0.0f, 4096, 'S', 10, "root", "/sbin/init"},
+      {42, 0.5f, 0.125f, 2048, 'R', 500, "alice", "make -j8"},
+      {77, 0.0f, 0.0f, 0, 'I', 900, "bob", "100% \"quoted\" %s"}};
+  Protocol::Summary const summary{MakeSummary()};
+  ProcessTable table;
+  Protocol::Encoder encoder;
+  Protocol::Decoder decoder;
+
+  Fill(table, processes);
+  std::string frame{encoder.Frame(summary, table)};
+  CHECK(decoder.Feed(frame.data(), frame.size()));
+  CHECK(decoder.Ready());
+  CHECK(decoder.Changed() == processes.size());
+  CheckSummary(decoder.System(), summary);
+  CheckRows(decoder, processes);
+
+  // Nothing changed: the frame carries the summary and no rows
+  std::string const idle{encoder.Frame(summary, table)};
+  CHECK(idle.size() < frame.size());
+  CHECK(decoder.Feed(idle.data(), idle.size()));
+  CHECK(decoder.Changed() == 0);
+  CheckRows(decoder, processes);
+
+  // One value changed, one process exited, one started, one PID reused
+  processes[1].cpu = 0.75f;
+  processes.erase(processes.begin());
+  processes[1].start_time = 1000;
+  processes[1].command = "reused";
+  processes.push_back({90, 0.02f, 0.5f, 1, 'D', 950, "carol", "dd"});
+  Fill(table, processes);
+  frame = encoder.Frame(summary, table);
+  CHECK(decoder.Feed(frame.data(), frame.size()));
+  CHECK(decoder.Changed() == 3);
+  CheckRows(decoder, processes);
+
+  // Same process, new argv or user, as after setproctitle() or setuid()
+  processes[0].command = "make -j8 [linking]";
+  processes[2].user = "nobody";
+  Fill(table, processes);
+  frame = encoder.Frame(summary, table);
+  CHECK(decoder.Feed(frame.data(), frame.size()));
+  CHECK(decoder.Changed() == 2);
+  CheckRows(decoder, processes);
+
+  // A sub-resolution change is not sent
+  processes[0].cpu += 0.00001f;
+  Fill(table, processes);
+  frame = encoder.Frame(summary, table);
+  CHECK(decoder.Feed(frame.data(), frame.size()));
+  CHECK(decoder.Changed() == 0);
+}
+
+void TestSplitFrames() {
+  std::vector<Process> const processes{
+      {1, 0.01f, 0.0f, 4096, 'S', 10, "root", "/sbin/init"},
+      {2, 0.02f, 0.0f, 0, 'S', 11, "root", ""}};
+  Protocol::Summary const summary{MakeSummary()};
+  ProcessTable table;
+  Fill(table, processes);
+  Protocol::Encoder encoder;
+  std::string stream{encoder.Frame(summary, table)};
+  std::size_t const first{stream.size()};
+  stream += encoder.Frame(summary, table);
+
+  // Every split of the first frame waits for the rest
+  for (std::size_t split = 0; split < first; ++split) {
+    Protocol::Decoder decoder;
+    CHECK(decoder.Feed(stream.data(), split));
+    CHECK(!decoder.Ready());
+    CHECK(decoder.Feed(stream.data() + split, stream.size() - split));
+    CHECK(decoder.Ready());
+    CheckRows(decoder, processes);
+  }
+
+  // One byte at a time
+  Protocol::Decoder decoder;
+  for (char byte : stream) CHECK(decoder.Feed(&byte, 1));
+  CHECK(decoder.Ready());
+  CHECK(decoder.Changed() == 0);
+  CheckRows(decoder, processes);
+}
+
+void TestMalformed() {
+  std::vector<Process> const processes{
+      {1, 0.01f, 0.0f, 4096, 'S', 10, "root", "/sbin/init"},
+      {2, 0.02f, 0.0f, 0, 'S', 11, "root", "sh"}};
+  Protocol::Summary const summary{MakeSummary()};
+  ProcessTable table;
+  Fill(table, processes);
+  Protocol::Encoder encoder;
+  std::string const frame{encoder.Frame(summary, table)};
+
+  // Payloads cut short, with a length prefix that agrees with the cut
+  for (std::size_t payload = 0; payload + 4 < frame.size(); ++payload) {
+    std::string truncated{frame.substr(0, 4 + payload)};
+    for (int i = 0; i < 4; ++i) truncated[i] = (char)(payload >> (8 * i));
+    Protocol::Decoder decoder;
+    CHECK(!decoder.Feed(truncated.data(), truncated.size()));
+  }
+
+  // Trailing bytes inside a frame
+  std::string padded{frame + '\0'};
+  std::uint32_t const size{(std::uint32_t)(frame.size() - 4 + 1)};
+  for (int i = 0; i < 4; ++i) padded[i] = (char)(size >> (8 * i));
+  Protocol::Decoder decoder;
+  CHECK(!decoder.Feed(padded.data(), padded.size()));
+
+  // A length prefix past the frame limit is rejected before buffering
+  std::uint32_t const huge{Protocol::kMaxFrameSize + 1};
+  char header[4];
+  for (int i = 0; i < 4; ++i) header[i] = (char)(huge >> (8 * i));
+  Protocol::Decoder oversized;
+  CHECK(!oversized.Feed(header, sizeof(header)));
+}
+}  // namespace
+
+int main() {
+  TestDeltas();
+  TestSplitFrames();
+  TestMalformed();
+  return Check::Result();
+}
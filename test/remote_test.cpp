@@ -0,0 +1,243 @@
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "protocol.h"
+#include "remote.h"
+
+/*
+Loopback test of the agent: two `monitor --serve` processes, one on a unix
+socket and one on TCP, each sampling a synthetic proc root. An unchanged
+tick must send no rows, and changing one process's CPU time, or its command
+through an exec, must send exactly one.
+Usage: remote_test path/to/monitor
+*/
+
+namespace fs = std::filesystem;
+
+namespace {
+const int kProcesses{20};
+const auto kTimeout{std::chrono::seconds(10)};
+
+void Write(const fs::path& path, const std::string& text) {
+  // Written aside and renamed, so the agent never reads half a file
+  fs::path const temporary{path.string() + ".new"};
+  std::ofstream(temporary, std::ios::binary) << text;
+  fs::rename(temporary, path);
+}
+
+std::string ProcessStat(int pid, long utime,
+                        const std::string& comm = "synthetic") {
+  return std::to_string(pid) + " (" + comm + " " + std::to_string(pid) +
+         ") S 1 1 1 0 -1 0 0 0 0 0 " + std::to_string(utime) + " " +
+         std::to_string(pid * 5) + " 0 0 20 0 1 0 " +
+         std::to_string(pid * 100) + " 1000 " + std::to_string(pid * 50) +
+         "\n";
+}
+
+void MakeProcRoot(const fs::path& root) {
+  fs::create_directories(root / "pressure");
+  Write(root / "stat",
+        "cpu  1000 10 500 8000 100 0 20 0 0 0\n"
+        "cpu0 1000 10 500 8000 100 0 20 0 0 0\n"
+        "processes 5000\nprocs_running 3\n");
+  Write(root / "meminfo", "MemTotal: 1000000 kB\nMemFree: 250000 kB\n");
+  Write(root / "uptime", "5000.5 4000.2\n");
+  Write(root / "version", "Linux version 6.1.0-synthetic (test) #1\n");
+  Write(root / "loadavg", "1.50 0.75 0.25 3/100 999\n");
+  for (const char* resource : {"cpu", "memory", "io"})
+    Write(root / "pressure" / resource,
+          "some avg10=0.00 avg60=0.00 avg300=0.00 total=1000\n");
+  for (int pid = 1; pid <= kProcesses; ++pid) {
+    fs::path const directory{root / std::to_string(pid)};
+    fs::create_directories(directory);
+    Write(directory / "stat", ProcessStat(pid, pid * 10));
+    Write(directory / "status", "Name:\tsyn\nUid:\t0\t0\t0\t0\n");
+    Write(directory / "cmdline",
+          std::string("/usr/bin/synthetic\0--id\0", 24) + std::to_string(pid));
+    Write(directory / "schedstat",
+          "100 " + std::to_string(pid * 1000) + " 3\n");
+  }
+}
+
+pid_t StartAgent(const std::string& monitor, const fs::path& root,
+                 const std::string& endpoint, const std::string& host) {
+  pid_t child = fork();
+  if (child == 0) {
+    execl(monitor.c_str(), monitor.c_str(), "--proc-root", root.c_str(),
+          "--serve", endpoint.c_str(), "--host", host.c_str(), nullptr);
+    _exit(127);
+  }
+  return child;
+}
+
+// A port nothing listens on right now
+std::string FreeTcpEndpoint() {
+  int fd = Remote::Listen("127.0.0.1:0");
+  sockaddr_storage address;
+  socklen_t length{sizeof(address)};
+  getsockname(fd, (sockaddr*)&address, &length);
+  close(fd);
+  int const port = ntohs(((sockaddr_in*)&address)->sin_port);
+  return "127.0.0.1:" + std::to_string(port);
+}
+
+// Reads whole frames from an agent, one Feed per frame, so that
+// Decoder::Changed() describes a single frame
+class Client {
+ public:
+  bool Open(const std::string& endpoint) {
+    auto const deadline{std::chrono::steady_clock::now() + kTimeout};
+    while (std::chrono::steady_clock::now() < deadline) {
+      for (const Remote::Address& address : Remote::Resolve(endpoint)) {
+        fd_ = Remote::Connect(address);
+        if (fd_ < 0) continue;
+        pollfd writable{fd_, POLLOUT, 0};
+        int error{0};
+        socklen_t length{sizeof(error)};
+        if (poll(&writable, 1, 1000) == 1 &&
+            getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length) == 0 &&
+            error == 0)
+          return true;
+        close(fd_);
+        fd_ = -1;
+      }
+      usleep(100 * 1000);  // the agent is still starting
+    }
+    return false;
+  }
+
+  ~Client() {
+    if (fd_ >= 0) close(fd_);
+  }
+
+  bool NextFrame() {
+    auto const deadline{std::chrono::steady_clock::now() + kTimeout};
+    while (1) {
+      if (buffer_.size() >= 4) {
+        std::uint32_t size{0};
+        for (int i = 0; i < 4; ++i)
+          size |= (std::uint32_t)(unsigned char)buffer_[i] << (8 * i);
+        if (buffer_.size() >= 4 + size) {
+          bool const ok = decoder_.Feed(buffer_.data(), 4 + size);
+          buffer_.erase(0, 4 + size);
+          return ok;
+        }
+      }
+      auto const left{std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now())};
+      pollfd readable{fd_, POLLIN, 0};
+      if (left.count() <= 0 || poll(&readable, 1, left.count()) != 1)
+        return false;
+      char chunk[1 << 16];
+      ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+      if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+      if (n <= 0) return false;
+      buffer_.append(chunk, n);
+    }
+  }
+
+  const Protocol::Decoder& State() const { return decoder_; }
+
+ private:
+  int fd_{-1};
+  std::string buffer_;
+  Protocol::Decoder decoder_;
+};
+
+void TestAgent(const std::string& monitor, const fs::path& root,
+               const std::string& endpoint, const std::string& host) {
+  MakeProcRoot(root);
+  pid_t const agent{StartAgent(monitor, root, endpoint, host)};
+  Client client;
+  CHECK(client.Open(endpoint));
+
+  // The first frame is a full snapshot
+  CHECK(client.NextFrame());
+  CHECK(client.State().Ready());
+  CHECK(client.State().System().host == host);
+  CHECK(client.State().Changed() == (std::size_t)kProcesses);
+  CHECK(client.State().Rows().size() == (std::size_t)kProcesses);
+
+  // Nothing under the root changed
+  CHECK(client.NextFrame());
+  CHECK(client.State().Changed() == 0);
+
+  // One process used more CPU; the change lands in one of the next frames
+  std::uint32_t const before{client.State().Rows().at(7).cpu};
+  Write(root / "7" / "stat", ProcessStat(7, 900));
+  std::size_t changed{0};
+  for (int frame = 0; frame < 3 && changed == 0; ++frame) {
+    CHECK(client.NextFrame());
+    changed = client.State().Changed();
+  }
+  CHECK(changed == 1);
+  CHECK(client.State().Rows().at(7).cpu > before);
+  CHECK(client.State().Rows().size() == (std::size_t)kProcesses);
+
+  // Process 9 exec()s: same PID and start time, new comm and command
+  Write(root / "9" / "cmdline", std::string("/usr/bin/exec\0ed", 16));
+  Write(root / "9" / "stat", ProcessStat(9, 90, "exec"));
+  changed = 0;
+  for (int frame = 0; frame < 3 && changed == 0; ++frame) {
+    CHECK(client.NextFrame());
+    changed = client.State().Changed();
+  }
+  CHECK(changed == 1);
+  CHECK(client.State().Rows().at(9).command == "/usr/bin/exec ed");
+
+  kill(agent, SIGTERM);
+  waitpid(agent, nullptr, 0);
+}
+
+// Listen may only take over a socket file nobody answers on
+void TestUnixListen(const fs::path& scratch) {
+  fs::path const file{scratch / "regular"};
+  Write(file, "keep");
+  CHECK(Remote::Listen("unix:" + file.string()) < 0);
+  CHECK(fs::is_regular_file(file));
+
+  std::string const endpoint{"unix:" + (scratch / "live.sock").string()};
+  int const live{Remote::Listen(endpoint)};
+  CHECK(live >= 0);
+  CHECK(Remote::Listen(endpoint) < 0);
+  close(live);
+  // Closed without unlinking, as after a crash
+  int const stale{Remote::Listen(endpoint)};
+  CHECK(stale >= 0);
+  close(stale);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "usage: remote_test path/to/monitor\n";
+    return 2;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  char directory[]{"/tmp/remote_test.XXXXXX"};
+  if (mkdtemp(directory) == nullptr) return 2;
+  fs::path const scratch{directory};
+
+  TestAgent(argv[1], scratch / "unix_root",
+            "unix:" + (scratch / "agent.sock").string(), "unix-agent");
+  TestAgent(argv[1], scratch / "tcp_root", FreeTcpEndpoint(), "tcp-agent");
+  TestUnixListen(scratch);
+
+  fs::remove_all(scratch);
+  return Check::Result();
+}